@@ -37,6 +37,7 @@ namespace gcsa
 // Numerical class constants.
 
 constexpr size_type KMerSearchParameters::SEED_LENGTH;
+constexpr size_type ApproximateSearchParameters::SEED_LENGTH;
 
 //------------------------------------------------------------------------------
 
@@ -81,6 +82,27 @@ printFailure(size_type& failure_count)
   return (failure_count <= MAX_ERRORS);
 }
 
+// Reference implementation of findMEMs() that uses find() for each substring.
+void
+findMEMsDirectly(const GCSA& index, const std::string& read, size_type min_length, std::vector<MEM>& results)
+{
+  results.clear();
+  for(size_type begin = 0; begin < read.length(); begin++)
+  {
+    size_type end = read.length();
+    range_type range = Range::empty_range();
+    while(end > begin)
+    {
+      range = index.find(read.begin() + begin, read.begin() + end);
+      if(!Range::empty(range)) { break; }
+      end--;
+    }
+    if(end == begin || end - begin < min_length) { continue; }
+    if(begin > 0 && !Range::empty(index.find(read.begin() + begin - 1, read.begin() + end))) { continue; }
+    results.push_back(MEM(begin, end, range));
+  }
+}
+
 struct KMerSplitComparator
 {
   inline bool operator() (const KMer& left, const KMer& right) const
@@ -90,6 +112,7 @@ struct KMerSplitComparator
 };
 
 const size_type RANDOM_LOCATE_SIZE = 10;  // Number of occurrences to locate.
+const size_type MEM_SAMPLE_PERIOD  = 64;  // Check findMEMs() for every nth kmer.
 
 bool
 verifyIndex(const GCSA& index, const LCPArray* lcp, const InputGraph& graph)
@@ -142,6 +165,33 @@ verifyIndex(const GCSA& index, const LCPArray* lcp, std::vector<KMer>& kmers, si
         i = next; continue;
       }
 
+      // findMEMs() for the kmer preceded by a mismatch. The search drops characters from
+      // the right end of the kmer, and the parent of the kmer may be deeper than the
+      // remaining match. We check every kmer where that happens and a sample of the rest.
+      if(lcp != 0 && endmarker_pos == std::string::npos &&
+        (i % MEM_SAMPLE_PERIOD == 0 || lcp->parent(range).lcp() >= kmer.length()))
+      {
+        for(comp_type comp = 1; comp < index.alpha.sigma; comp++)
+        {
+          if(!Range::empty(index.LF(range, comp))) { continue; }
+          std::string read = static_cast<char>(index.alpha.comp2char[comp]) + kmer;
+          std::vector<MEM> mems, expected_mems;
+          findMEMs(index, *lcp, read, 1, mems);
+          findMEMsDirectly(index, read, 1, expected_mems);
+          if(mems != expected_mems)
+          {
+            #pragma omp critical
+            {
+              if(printFailure(fails))
+              {
+                std::cerr << "verifyIndex(): findMEMs(" << read << ") does not match find()" << std::endl;
+              }
+            }
+            break;
+          }
+        }
+      }
+
       // parent() and depth()
       if(lcp != 0)
       {
@@ -617,6 +667,335 @@ compareKMers(const GCSA& left, const GCSA& right, size_type k, const KMerSearchP
 
 //------------------------------------------------------------------------------
 
+struct ApproximateSearchState
+{
+  range_type range;
+  size_type  remaining; // Length of the unmatched prefix of the pattern.
+  size_type  errors;
+  size_type  depth;
+
+  ApproximateSearchState() : range(0, 0), remaining(0), errors(0), depth(0) {}
+  ApproximateSearchState(range_type rng, size_type length) : range(rng), remaining(length), errors(0), depth(0) {}
+  ApproximateSearchState(range_type rng, size_type length, size_type errs, const ApproximateSearchState& successor) :
+    range(rng), remaining(length), errors(errs), depth(successor.depth + 1)
+  {
+  }
+};
+
+struct ApproximateSeedCollector
+{
+  size_type                           seed_length;
+  std::vector<ApproximateSearchState> seeds;
+
+  explicit ApproximateSeedCollector(size_type length) : seed_length(length), seeds() {}
+
+  inline bool reportCondition(const ApproximateSearchState& state) const
+  {
+    return (state.remaining == 0 || state.depth == this->seed_length);
+  }
+
+  inline bool expandCondition(const ApproximateSearchState& state) const
+  {
+    return (state.remaining > 0 && state.depth < this->seed_length);
+  }
+
+  inline void report(const ApproximateSearchState& state)
+  {
+    this->seeds.push_back(state);
+  }
+};
+
+struct ApproximateMatcher
+{
+  std::vector<std::pair<range_type, size_type>> matches;
+
+  inline bool reportCondition(const ApproximateSearchState& state) const
+  {
+    return (state.remaining == 0);
+  }
+
+  inline bool expandCondition(const ApproximateSearchState& state) const
+  {
+    return (state.remaining > 0);
+  }
+
+  inline void report(const ApproximateSearchState& state)
+  {
+    this->matches.push_back(std::make_pair(state.range, state.errors));
+  }
+};
+
+/*
+  lower_bound[i] is a lower bound for the number of errors in pattern[0, i). We partition
+  the prefix greedily into substrings that do not occur in the index.
+
+  Backward search cannot extend a substring to the right, so we find the shortest
+  non-occurring pattern[start, end) using exponential and binary search over end. As
+  the prefixes of an occurring substring also occur, this gives the same partition
+  with O(length log length) instead of O(length^2) LF() steps per segment.
+*/
+std::vector<size_type>
+approximateLowerBounds(const GCSA& index, const std::string& pattern)
+{
+  std::vector<size_type> lower_bound(pattern.length() + 1, 0);
+  size_type start = 0, count = 0;
+  while(start < pattern.length())
+  {
+    // pattern[start, low) occurs; pattern[start, high) does not or high > length.
+    size_type low = start, high = start + 1;
+    while(high <= pattern.length() && !Range::empty(index.find(pattern.begin() + start, pattern.begin() + high)))
+    {
+      low = high; high = start + 2 * (high - start);
+    }
+    high = std::min(high, pattern.length() + 1);
+    while(high - low > 1)
+    {
+      size_type mid = low + (high - low) / 2;
+      if(Range::empty(index.find(pattern.begin() + start, pattern.begin() + mid))) { high = mid; }
+      else { low = mid; }
+    }
+
+    for(size_type i = start + 1; i < high && i <= pattern.length(); i++) { lower_bound[i] = count; }
+    if(high > pattern.length()) { break; }
+    count++; lower_bound[high] = count; start = high;
+  }
+  return lower_bound;
+}
+
+template<class Handler>
+void
+processApproximate(const GCSA& index, const std::string& pattern, size_type k,
+  const std::vector<size_type>& lower_bound, const ApproximateSearchParameters& parameters,
+  std::stack<ApproximateSearchState>& state_stack, Handler& handler)
+{
+  std::vector<range_type> pred(index.alpha.sigma);
+  size_type limit = (parameters.include_Ns ? index.alpha.sigma : index.alpha.fast_chars + 2);
+  bool indels = (parameters.distance == ApproximateSearchParameters::EDIT);
+  while(!(state_stack.empty()))
+  {
+    ApproximateSearchState curr = state_stack.top(); state_stack.pop();
+    if(Range::empty(curr.range)) { continue; }
+    if(handler.reportCondition(curr)) { handler.report(curr); }
+    if(!(handler.expandCondition(curr))) { continue; }
+
+    bool internal = (curr.remaining < pattern.length());
+    if(parameters.include_Ns) { index.LF_all(curr.range, pred); }
+    else { index.LF_fast(curr.range, pred); }
+    comp_type next = index.alpha.char2comp[static_cast<char_type>(pattern[curr.remaining - 1])];
+    for(size_type comp = 1; comp + 1 < limit; comp++)
+    {
+      if(Range::empty(pred[comp])) { continue; }
+      size_type errors = curr.errors + (comp == next ? 0 : 1);
+      if(errors + lower_bound[curr.remaining - 1] <= k)
+      {
+        state_stack.push(ApproximateSearchState(pred[comp], curr.remaining - 1, errors, curr));
+      }
+      // Deletion from the pattern.
+      if(indels && internal && curr.errors + 1 + lower_bound[curr.remaining] <= k)
+      {
+        state_stack.push(ApproximateSearchState(pred[comp], curr.remaining, curr.errors + 1, curr));
+      }
+    }
+    // Insertion to the pattern.
+    if(indels && internal && curr.remaining > 1 && curr.errors + 1 + lower_bound[curr.remaining - 1] <= k)
+    {
+      state_stack.push(ApproximateSearchState(curr.range, curr.remaining - 1, curr.errors + 1, curr));
+    }
+  }
+}
+
+void
+approximateSearch(const GCSA& index, const std::string& pattern, size_type k,
+  std::vector<std::pair<range_type, size_type>>& results,
+  const ApproximateSearchParameters& parameters)
+{
+  results.clear();
+  if(index.empty()) { return; }
+
+  std::vector<size_type> lower_bound = approximateLowerBounds(index, pattern);
+  if(lower_bound.back() > k) { return; }
+
+  // Create an array of seed states.
+  std::vector<ApproximateSearchState> seeds;
+  {
+    std::stack<ApproximateSearchState> state_stack;
+    state_stack.push(ApproximateSearchState(range_type(0, index.size() - 1), pattern.length()));
+    ApproximateSeedCollector collector(parameters.seed_length);
+    processApproximate(index, pattern, k, lower_bound, parameters, state_stack, collector);
+    seeds = collector.seeds;
+  }
+
+  // Extend the seeds in parallel.
+  #pragma omp parallel for schedule (dynamic, 1)
+  for(size_type i = 0; i < seeds.size(); i++)
+  {
+    std::stack<ApproximateSearchState> state_stack;
+    state_stack.push(seeds[i]);
+    ApproximateMatcher matcher;
+    processApproximate(index, pattern, k, lower_bound, parameters, state_stack, matcher);
+    #pragma omp critical
+    {
+      results.insert(results.end(), matcher.matches.begin(), matcher.matches.end());
+    }
+  }
+
+  // Report each range once with the smallest number of errors.
+  std::sort(results.begin(), results.end());
+  results.erase(std::unique(results.begin(), results.end(),
+    [](const std::pair<range_type, size_type>& a, const std::pair<range_type, size_type>& b)
+    {
+      return (a.first == b.first);
+    }), results.end());
+}
+
+//------------------------------------------------------------------------------
+
+BidirectionalSearch::BidirectionalSearch(const GCSA& gcsa) :
+  index(gcsa)
+{
+  this->clear();
+}
+
+void
+BidirectionalSearch::clear()
+{
+  this->text.clear();
+  this->forward = this->reverse = range_type(0, this->index.size() - 1);
+  this->forward_valid = this->reverse_valid = true;
+}
+
+bool
+BidirectionalSearch::extendLeft(char_type c)
+{
+  range_type curr = this->range();
+  comp_type comp = this->index.alpha.char2comp[c];
+  if(this->length() == 0) { curr = this->index.charRange(comp); }
+  else { curr = this->index.LF(curr, comp); }
+  if(Range::empty(curr)) { return false; }
+
+  this->text.insert(this->text.begin(), c);
+  this->forward = curr;
+  this->reverse_valid = false;
+  return true;
+}
+
+bool
+BidirectionalSearch::extendRight(char_type c)
+{
+  range_type curr = this->rcRange();
+  comp_type comp = this->index.alpha.char2comp[complement(c)];
+  if(this->length() == 0) { curr = this->index.charRange(comp); }
+  else { curr = this->index.LF(curr, comp); }
+  if(Range::empty(curr)) { return false; }
+
+  this->text.push_back(c);
+  this->reverse = curr;
+  this->forward_valid = false;
+  return true;
+}
+
+range_type
+BidirectionalSearch::range()
+{
+  if(!(this->forward_valid))
+  {
+    this->forward = this->index.find(this->text);
+    this->forward_valid = true;
+  }
+  return this->forward;
+}
+
+range_type
+BidirectionalSearch::rcRange()
+{
+  if(!(this->reverse_valid))
+  {
+    // Backward search for rc(P) processes P from left to right.
+    range_type curr = this->index.charRange(this->index.alpha.char2comp[complement(this->text.front())]);
+    for(size_type i = 1; i < this->length() && !Range::empty(curr); i++)
+    {
+      curr = this->index.LF(curr, this->index.alpha.char2comp[complement(this->text[i])]);
+    }
+    this->reverse = curr;
+    this->reverse_valid = true;
+  }
+  return this->reverse;
+}
+
+char_type
+BidirectionalSearch::complement(char_type c)
+{
+  switch(c)
+  {
+  case 'A': return 'T';
+  case 'C': return 'G';
+  case 'G': return 'C';
+  case 'T': return 'A';
+  case 'a': return 't';
+  case 'c': return 'g';
+  case 'g': return 'c';
+  case 't': return 'a';
+  default:  return c;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void
+findMEMs(const GCSA& index, const LCPArray& lcp, const std::string& read, size_type min_length,
+  std::vector<MEM>& results)
+{
+  results.clear();
+  if(index.empty()) { return; }
+
+  // The current match is read[start, end) and its range is curr. The match is the
+  // longest one starting at start, unless it has already been shortened.
+  size_type start = read.length(), end = read.length();
+  range_type curr(0, index.size() - 1);
+  bool longest = false;
+  while(start > 0)
+  {
+    comp_type comp = index.alpha.char2comp[static_cast<char_type>(read[start - 1])];
+    range_type next = Range::empty_range();
+    if(comp > 0) { next = (start == end ? index.charRange(comp) : index.LF(curr, comp)); }
+    if(!Range::empty(next))
+    {
+      curr = next; start--; longest = true;
+      continue;
+    }
+
+    // The match cannot be extended to the left.
+    if(longest && end - start >= min_length) { results.push_back(MEM(start, end, curr)); }
+    longest = false;
+    if(start == end) { start--; end--; continue; }
+
+    // Drop characters from the right end of the match until it can be extended. The
+    // parent may be deeper than the match, if the path labels in the range are longer
+    // than the match. Then the range of any shorter match is that of a higher ancestor.
+    LCPArray::node_type parent = lcp.parent(curr);
+    while(parent.lcp() >= end - start) { parent = lcp.parent(parent); }
+    end = start + parent.lcp();
+    curr = (parent.lcp() > 0 ? parent.range() : range_type(0, index.size() - 1));
+  }
+  if(longest && end - start >= min_length) { results.push_back(MEM(start, end, curr)); }
+
+  std::reverse(results.begin(), results.end());
+}
+
+void
+findMEMs(const GCSA& index, const LCPArray& lcp, const std::vector<std::string>& reads, size_type min_length,
+  std::vector<std::vector<MEM>>& results)
+{
+  results.resize(reads.size());
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(size_type i = 0; i < reads.size(); i++)
+  {
+    findMEMs(index, lcp, reads[i], min_length, results[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+
 void
 printStatistics(const GCSA& gcsa, const LCPArray& lcp_array)
 {
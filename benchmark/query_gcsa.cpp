@@ -29,6 +29,8 @@ using namespace gcsa;
 
 //------------------------------------------------------------------------------
 
+const size_type APPROXIMATE_ERRORS = 1; // Mismatches in approximate search of full patterns.
+
 size_type filter(std::vector<std::string>& patterns);
 
 int
@@ -66,6 +68,11 @@ main(int argc, char** argv)
     std::exit(EXIT_FAILURE);
   }
 
+  // The kmer table is optional.
+  KMerTable table;
+  std::string table_name = base_name + KMerTable::EXTENSION;
+  bool has_table = sdsl::load_from_file(table, table_name);
+
   if(pattern_name.empty())
   {
     printStatistics(index, lcp);
@@ -74,7 +81,16 @@ main(int argc, char** argv)
   else
   {
     printHeader("GCSA"); std::cout << inMegabytes(sdsl::size_in_bytes(index)) << " MB" << std::endl;
+    // find(batch) can only prefetch the packed BWT and the cache line rank bitvectors.
+    printHeader("BWT encoding");
+    std::cout << (index.packed() ? "packed" : (index.runLength() ? "run-length" : "plain"))
+              << (index.rankVectors() ? ", rank blocks" : "") << std::endl;
     printHeader("LCP"); std::cout << inMegabytes(sdsl::size_in_bytes(lcp)) << " MB" << std::endl;
+    if(has_table)
+    {
+      printHeader("Kmer table");
+      std::cout << inMegabytes(sdsl::size_in_bytes(table)) << " MB (length " << table.length() << ")" << std::endl;
+    }
   }
 
   std::vector<std::string> patterns;
@@ -86,6 +102,8 @@ main(int argc, char** argv)
 
   std::vector<range_type> ranges; ranges.reserve(patterns.size());
   std::vector<size_type> lengths; lengths.reserve(patterns.size());
+  double scalar_seconds = 0.0;
+  size_type scalar_total = 0;
   {
     double start = readTimer();
     size_type total = 0;
@@ -101,6 +119,73 @@ main(int argc, char** argv)
     std::cout << "Found " << ranges.size() << " patterns matching " << total << " paths ("
               << (inMegabytes(pattern_total) / seconds) << " MB/s)" << std::endl;
     std::cout << std::endl;
+    scalar_seconds = seconds; scalar_total = total;
+  }
+
+  {
+    double start = readTimer();
+    std::vector<range_type> batch;
+    index.find(patterns, batch);
+    double seconds = readTimer() - start;
+    size_type found = 0, total = 0;
+    for(size_type i = 0; i < batch.size(); i++)
+    {
+      if(!Range::empty(batch[i])) { found++; }
+      total += Range::length(batch[i]);
+    }
+    printTime("find(batch)", patterns.size(), seconds);
+    printHeader("find(batch)");
+    std::cout << "Found " << found << " patterns matching " << total << " paths ("
+              << (inMegabytes(pattern_total) / seconds) << " MB/s, "
+              << (scalar_seconds / seconds) << "x scalar)" << std::endl;
+    std::cout << std::endl;
+    if(found != ranges.size() || total != scalar_total)
+    {
+      std::cout << "Warning: find() and find(batch) returned inconsistent results" << std::endl;
+      std::cout << std::endl;
+    }
+  }
+
+  if(has_table)
+  {
+    double start = readTimer();
+    size_type found = 0, total = 0;
+    for(size_type i = 0; i < patterns.size(); i++)
+    {
+      range_type temp = table.find(index, patterns[i]);
+      if(!Range::empty(temp)) { found++; }
+      total += Range::length(temp);
+    }
+    double seconds = readTimer() - start;
+    printTime("find(table)", patterns.size(), seconds);
+    printHeader("find(table)");
+    std::cout << "Found " << found << " patterns matching " << total << " paths ("
+              << (inMegabytes(pattern_total) / seconds) << " MB/s, "
+              << (scalar_seconds / seconds) << "x scalar)" << std::endl;
+    std::cout << std::endl;
+    if(found != ranges.size())
+    {
+      std::cout << "Warning: find() and find(table) returned inconsistent results" << std::endl;
+      std::cout << std::endl;
+    }
+  }
+
+  {
+    double start = readTimer();
+    size_type found = 0, total = 0;
+    std::vector<std::pair<range_type, size_type>> results;
+    for(size_type i = 0; i < patterns.size(); i++)
+    {
+      approximateSearch(index, patterns[i], APPROXIMATE_ERRORS, results);
+      if(!(results.empty())) { found++; }
+      total += results.size();
+    }
+    double seconds = readTimer() - start;
+    printTime("approximate()", patterns.size(), seconds);
+    printHeader("approximate()");
+    std::cout << "Found " << found << " patterns with up to " << APPROXIMATE_ERRORS << " mismatches in "
+              << total << " ranges (" << (inMegabytes(pattern_total) / seconds) << " MB/s)" << std::endl;
+    std::cout << std::endl;
   }
 
   std::vector<range_type> parents(ranges.size());
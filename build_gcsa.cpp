@@ -23,6 +23,7 @@
   SOFTWARE.
 */
 
+#include <memory>
 #include <string>
 #include <unistd.h>
 
@@ -45,16 +46,26 @@ main(int argc, char** argv)
     std::cerr << "Input/output options:" << std::endl;
     std::cerr << "  -b    Read the input in binary format (default)" << std::endl;
     std::cerr << "  -t    Read the input in text format" << std::endl;
+    std::cerr << "  -p    Stream the input from pipes or other files given by name (- for stdin)" << std::endl;
     std::cerr << "  -o X  Use X as the base name for output (default: the first input)" << std::endl;
     std::cerr << "Index construction options:" << std::endl;
     std::cerr << "  -d N  Doubling steps (default " << ConstructionParameters::DOUBLING_STEPS << ", max " << ConstructionParameters::MAX_STEPS << ")" << std::endl;
     std::cerr << "  -m X  Use node mapping from file X" << std::endl;
     std::cerr << "  -s N  Use sample period N (default " << ConstructionParameters::SAMPLE_PERIOD << ")" << std::endl;
     std::cerr << "  -B N  Set LCP branching factor to N (default " << ConstructionParameters::LCP_BRANCHING << ")" << std::endl;
+    std::cerr << "  -P    Use the packed BWT encoding (faster queries, larger index)" << std::endl;
+    std::cerr << "  -R    Use the run-length BWT encoding (for highly repetitive graphs)" << std::endl;
+    std::cerr << "  -S    Store the sparse characters in a single combined structure" << std::endl;
+    std::cerr << "  -r    Use cache line rank bitvectors (mappable, larger index)" << std::endl;
+    std::cerr << "  -M    Write the index and the LCP array in the mappable layout" << std::endl;
+    std::cerr << "  -K N  Also build a lookup table for kmers of length N (suggested " << KMerTable::DEFAULT_LENGTH << ")" << std::endl;
     std::cerr << "  -L    Load the index instead of building it" << std::endl;
+    std::cerr << "  -H X  Back the query structures with huge pages (X = transparent or explicit)" << std::endl;
     std::cerr << "  -v    Verify the index by querying it with the kmers" << std::endl;
     std::cerr << "Other options:" << std::endl;
     std::cerr << "  -D X  Use X as the directory for temporary files (default: " << TempFile::DEFAULT_TEMP_DIR << ")" << std::endl;
+    std::cerr << "  -C    Compress the temporary files used in prefix-doubling" << std::endl;
+    std::cerr << "  -c    Drop the temporary files from the page cache after use (Linux)" << std::endl;
     std::cerr << "  -l N  Limit disk space usage to N gigabytes (default " << ConstructionParameters::SIZE_LIMIT << ")" << std::endl;
     std::cerr << "  -T N  Set the number of threads to N (default and max " << omp_get_max_threads() << " on this system)" << std::endl;
     std::cerr << "  -V N  Set verbosity level to N (default " << Verbosity::DEFAULT << ")" << std::endl;
@@ -63,10 +74,11 @@ main(int argc, char** argv)
   }
 
   int c = 0;
-  bool binary = true, load_index = false, verify = false;
-  std::string index_file, lcp_file, mapping_file;
+  bool binary = true, streaming = false, load_index = false, verify = false;
+  size_type table_length = 0;
+  std::string index_file, lcp_file, table_file, mapping_file;
   ConstructionParameters parameters;
-  while((c = getopt(argc, argv, "bto:d:m:s:B:LvD:l:T:V:")) != -1)
+  while((c = getopt(argc, argv, "btpo:d:m:s:B:PRSrMK:LH:vD:Ccl:T:V:")) != -1)
   {
     switch(c)
     {
@@ -74,9 +86,12 @@ main(int argc, char** argv)
       binary = true; break;
     case 't':
       binary = false; break;
+    case 'p':
+      streaming = true; break;
     case 'o':
       index_file = std::string(optarg) + GCSA::EXTENSION;
       lcp_file = std::string(optarg) + LCPArray::EXTENSION;
+      table_file = std::string(optarg) + KMerTable::EXTENSION;
       break;
     case 'd':
       parameters.setSteps(std::stoul(optarg)); break;
@@ -86,12 +101,37 @@ main(int argc, char** argv)
       parameters.setSamplePeriod(std::stoul(optarg)); break;
     case 'B':
       parameters.setLCPBranching(std::stoul(optarg)); break;
+    case 'P':
+      parameters.setPackedBWT(true); break;
+    case 'R':
+      parameters.setRunLengthBWT(true); break;
+    case 'S':
+      parameters.setCombinedSparse(true); break;
+    case 'r':
+      parameters.setRankVectors(true); break;
+    case 'M':
+      parameters.setMappable(true); break;
+    case 'K':
+      table_length = std::stoul(optarg); break;
     case 'L':
       load_index = true; break;
+    case 'H':
+      if(std::string(optarg) == "transparent") { HugePages::set(HugePages::TRANSPARENT); }
+      else if(std::string(optarg) == "explicit") { HugePages::set(HugePages::EXPLICIT); }
+      else
+      {
+        std::cerr << "build_gcsa: Invalid huge page mode: " << optarg << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      break;
     case 'v':
       verify = true; break;
     case 'D':
       TempFile::setDirectory(optarg); break;
+    case 'C':
+      parameters.setCompressTemp(true); break;
+    case 'c':
+      TempFile::drop_cache = true; break;
     case 'l':
       parameters.setLimit(std::stoul(optarg)); break;
     case 'T':
@@ -109,10 +149,21 @@ main(int argc, char** argv)
     std::cerr << "build_gcsa: No input files specified" << std::endl;
     std::exit(EXIT_FAILURE);
   }
+  if(streaming && (load_index || verify))
+  {
+    std::cerr << "build_gcsa: Streaming input cannot be used with -L or -v" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  if(streaming && index_file.empty())
+  {
+    std::cerr << "build_gcsa: Streaming input requires -o" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
   if(index_file.empty())
   {
     index_file = std::string(argv[optind]) + GCSA::EXTENSION;
     lcp_file = std::string(argv[optind]) + LCPArray::EXTENSION;
+    table_file = std::string(argv[optind]) + KMerTable::EXTENSION;
   }
 
   Version::print(std::cout, "GCSA2 builder");
@@ -120,27 +171,53 @@ main(int argc, char** argv)
   {
     printHeader("Input", INDENT);
     std::cout << argv[i];
-    if(binary) { std::cout << InputGraph::BINARY_EXTENSION << " (binary format)" << std::endl; }
+    if(streaming) { std::cout << (binary ? " (binary stream)" : " (text stream)") << std::endl; }
+    else if(binary) { std::cout << InputGraph::BINARY_EXTENSION << " (binary format)" << std::endl; }
     else { std::cout << InputGraph::TEXT_EXTENSION << " (text format)" << std::endl; }
   }
   if(!(mapping_file.empty()))
   {
     printHeader("Node mapping", INDENT); std::cout << mapping_file << std::endl;
   }
-  printHeader("Output", INDENT); std::cout << index_file << ", " << lcp_file << std::endl;
+  printHeader("Output", INDENT); std::cout << index_file << ", " << lcp_file;
+  if(table_length > 0) { std::cout << ", " << table_file; }
+  std::cout << std::endl;
+  if(HugePages::mode != HugePages::NORMAL) { printHeader("Huge pages", INDENT); std::cout << HugePages::modeName() << std::endl; }
   if(!load_index)
   {
     printHeader("Doubling steps", INDENT); std::cout << parameters.doubling_steps << std::endl;
     printHeader("Sample period", INDENT); std::cout << parameters.sample_period << std::endl;
     printHeader("Branching factor", INDENT); std::cout << parameters.lcp_branching << std::endl;
+    if(parameters.getPackedBWT()) { printHeader("BWT encoding", INDENT); std::cout << "packed" << std::endl; }
+    if(parameters.getRunLengthBWT()) { printHeader("BWT encoding", INDENT); std::cout << "run-length" << std::endl; }
+    if(parameters.getCombinedSparse()) { printHeader("Sparse encoding", INDENT); std::cout << "combined" << std::endl; }
+    if(parameters.getRankVectors()) { printHeader("Bitvectors", INDENT); std::cout << "rank blocks" << std::endl; }
+    if(parameters.getMappable()) { printHeader("File layout", INDENT); std::cout << "mappable" << std::endl; }
+    if(table_length > 0) { printHeader("Kmer table", INDENT); std::cout << "length " << table_length << std::endl; }
     printHeader("Temp directory", INDENT); std::cout << TempFile::temp_dir << std::endl;
+    if(parameters.getCompressTemp()) { printHeader("Temp files", INDENT); std::cout << "compressed" << std::endl; }
+    if(TempFile::drop_cache) { printHeader("Page cache", INDENT); std::cout << "drop temp files" << std::endl; }
     printHeader("Size limit", INDENT); std::cout << inGigabytes(parameters.size_limit) << " GB" << std::endl;
     printHeader("Threads", INDENT); std::cout << omp_get_max_threads() << std::endl;
+    printHeader("LCP kernel", INDENT); std::cout << LCPArray::kernelName() << std::endl;
     printHeader("Verbosity", INDENT); std::cout << Verbosity::levelName() << std::endl;
   }
   std::cout << std::endl;
 
-  InputGraph graph(argc - optind, argv + optind, binary, Alphabet(), mapping_file);
+  std::unique_ptr<InputGraph> input;
+  if(streaming)
+  {
+    std::vector<KMerProducer> producers;
+    std::vector<std::string> names;
+    for(int i = optind; i < argc; i++)
+    {
+      producers.push_back(streamProducer(argv[i], binary));
+      names.push_back(argv[i]);
+    }
+    input.reset(new InputGraph(producers, names, Alphabet(), mapping_file));
+  }
+  else { input.reset(new InputGraph(argc - optind, argv + optind, binary, Alphabet(), mapping_file)); }
+  InputGraph& graph = *input;
 
   GCSA index;
   LCPArray lcp;
@@ -180,6 +257,20 @@ main(int argc, char** argv)
     }
   }
 
+  if(table_length > 0)
+  {
+    double start = readTimer();
+    KMerTable table(index, table_length);
+    double seconds = readTimer() - start;
+    std::cout << "Kmer table (length " << table.length() << ") built in " << seconds << " seconds" << std::endl;
+    std::cout << std::endl;
+    if(!sdsl::store_to_file(table, table_file))
+    {
+      std::cerr << "build_gcsa: Cannot write the kmer table to " << table_file << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
   printStatistics(index, lcp);
 
   if(verify) { verifyIndex(index, &lcp, graph); }
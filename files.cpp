@@ -38,10 +38,19 @@ constexpr size_type InputGraph::UNKNOWN;
 constexpr uint32_t GCSAHeader::TAG;
 constexpr uint32_t GCSAHeader::VERSION;
 constexpr uint32_t GCSAHeader::MIN_VERSION;
+constexpr uint32_t GCSAHeader::COMPATIBLE_VERSION;
+constexpr uint64_t GCSAHeader::PACKED_BWT;
+constexpr uint64_t GCSAHeader::MAPPABLE;
+constexpr uint64_t GCSAHeader::RUN_LENGTH_BWT;
+constexpr uint64_t GCSAHeader::COMBINED_SPARSE;
+constexpr uint64_t GCSAHeader::RANK_VECTORS;
+constexpr uint64_t GCSAHeader::FLAG_MASK;
 
 constexpr uint32_t LCPHeader::TAG;
 constexpr uint32_t LCPHeader::VERSION;
 constexpr uint32_t LCPHeader::MIN_VERSION;
+constexpr uint64_t LCPHeader::MAPPABLE;
+constexpr uint64_t LCPHeader::FLAG_MASK;
 
 //------------------------------------------------------------------------------
 
@@ -52,71 +61,206 @@ const std::string InputGraph::TEXT_EXTENSION = ".gcsa2";
 
 //------------------------------------------------------------------------------
 
-bool
-tokenize(const std::string& line, std::vector<std::string>& tokens)
+/*
+  A kmer line tokenized in place. Token i is [begin[i], end[i]) and the last token is
+  the comma-separated list of successor positions.
+*/
+struct KMerLine
 {
+  constexpr static size_type TOKENS = 5;
+
+  const char* begin[TOKENS];
+  const char* end[TOKENS];
+
+  // Returns false if the line does not contain 5 tokens.
+  bool tokenize(const char* line_begin, const char* line_end)
   {
-    std::string token;
-    std::istringstream ss(line);
-    while(std::getline(ss, token, '\t'))
+    size_type token = 0;
+    const char* iter = line_begin;
+    while(iter != line_end)
     {
-      tokens.push_back(token);
+      const char* token_end = std::find(iter, line_end, '\t');
+      if(token < TOKENS) { this->begin[token] = iter; this->end[token] = token_end; }
+      token++;
+      iter = (token_end == line_end ? token_end : token_end + 1);
     }
-    if(tokens.size() != 5)
+    return (token == TOKENS);
+  }
+
+  size_type length() const { return this->end[0] - this->begin[0]; }
+
+  // Calls f(successor_begin, successor_end) for each successor position.
+  template<class Function>
+  void successors(Function f) const
+  {
+    const char* iter = this->begin[TOKENS - 1];
+    while(iter != this->end[TOKENS - 1])
     {
-      std::cerr << "tokenize(): The kmer line must contain 5 tokens" << std::endl;
-      std::cerr << "tokenize(): The line was: " << line << std::endl;
+      const char* token_end = std::find(iter, this->end[TOKENS - 1], ',');
+      f(iter, token_end);
+      iter = (token_end == this->end[TOKENS - 1] ? token_end : token_end + 1);
+    }
+  }
+};
+
+/*
+  The kmers parsed from a block of lines. kmer_length is the length of the first kmer
+  and invalid_length the first length that differs from it.
+*/
+struct TextBlock
+{
+  std::vector<KMer> kmers;
+  size_type         kmer_count, kmer_length, invalid_length;
+
+  TextBlock() : kmer_count(0), kmer_length(InputGraph::UNKNOWN), invalid_length(InputGraph::UNKNOWN) { }
+
+  // Returns false if the length is invalid.
+  bool setLength(size_type length)
+  {
+    if(this->kmer_length == InputGraph::UNKNOWN) { this->kmer_length = length; }
+    else if(length != this->kmer_length)
+    {
+      if(this->invalid_length == InputGraph::UNKNOWN) { this->invalid_length = length; }
       return false;
     }
+    return true;
   }
+};
+
+// Each thread parses blocks of approximately this many bytes.
+const size_type TEXT_BLOCK_SIZE = 4 * MEGABYTE;
 
-  // Split the list of successor positions into separate tokens.
-  std::string destinations = tokens[4], token;
-  std::istringstream ss(destinations);
-  tokens.resize(4);
-  while(std::getline(ss, token, ','))
+/*
+  Reads the text input in batches of blocks of complete lines and parses the blocks of
+  each batch in parallel with parser(block_begin, block_end, block). Then calls
+  merge(block) for the blocks in order.
+*/
+template<class Parser, class Merger>
+void
+parseText(std::istream& in, const Parser& parser, const Merger& merge)
+{
+  size_type threads = omp_get_max_threads();
+  std::vector<char> buffer;
+  bool eof = false;
+  while(!eof)
   {
-    tokens.push_back(token);
+    // Read a batch after the incomplete line from the previous batch.
+    size_type old_size = buffer.size();
+    buffer.resize(old_size + threads * TEXT_BLOCK_SIZE);
+    in.read(buffer.data() + old_size, threads * TEXT_BLOCK_SIZE);
+    buffer.resize(old_size + in.gcount());
+    eof = !in;
+    size_type batch_end = buffer.size();
+    if(!eof)
+    {
+      while(batch_end > 0 && buffer[batch_end - 1] != '\n') { batch_end--; }
+      if(batch_end == 0) { continue; }  // The line is longer than the batch.
+    }
+
+    // Split the batch into blocks at line boundaries.
+    std::vector<size_type> bounds(1, 0);
+    while(bounds.back() < batch_end)
+    {
+      size_type next = std::min(bounds.back() + TEXT_BLOCK_SIZE, batch_end);
+      while(next < batch_end && buffer[next - 1] != '\n') { next++; }
+      bounds.push_back(next);
+    }
+
+    std::vector<TextBlock> blocks(bounds.size() - 1);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(size_type block = 0; block < blocks.size(); block++)
+    {
+      parser(buffer.data() + bounds[block], buffer.data() + bounds[block + 1], blocks[block]);
+    }
+    for(size_type block = 0; block < blocks.size(); block++) { merge(blocks[block]); }
+
+    buffer.erase(buffer.begin(), buffer.begin() + batch_end);
   }
+}
 
-  return true;
+// Calls f(line_begin, line_end) for each line in the block.
+template<class Function>
+void
+forEachLine(const char* block_begin, const char* block_end, Function f)
+{
+  while(block_begin != block_end)
+  {
+    const char* line_end = std::find(block_begin, block_end, '\n');
+    f(block_begin, line_end);
+    block_begin = (line_end == block_end ? line_end : line_end + 1);
+  }
 }
 
-size_type
-readText(std::istream& in, std::vector<KMer>& kmers, const Alphabet& alpha, bool append)
+struct KMerParser
 {
-  if(!append) { sdsl::util::clear(kmers); }
+  const Alphabet& alpha;
 
-  size_type kmer_length = ~(size_type)0;
-  while(true)
-  {
-    std::string line;
-    std::getline(in, line);
-    if(!in) { break; }
+  explicit KMerParser(const Alphabet& alphabet) : alpha(alphabet) { }
 
-    std::vector<std::string> tokens;
-    if(!tokenize(line, tokens)) { continue; }
-    if(kmer_length == ~(size_type)0)
+  void operator() (const char* block_begin, const char* block_end, TextBlock& block) const
+  {
+    forEachLine(block_begin, block_end, [&](const char* line_begin, const char* line_end)
     {
-      kmer_length = tokens[0].length();
-      if(kmer_length == 0 || kmer_length > Key::MAX_LENGTH)
+      KMerLine line;
+      if(!(line.tokenize(line_begin, line_end)))
       {
-        std::cerr << "readText(): Invalid kmer length: " << kmer_length << std::endl;
-        std::exit(EXIT_FAILURE);
+        #pragma omp critical
+        {
+          std::cerr << "readText(): The kmer line must contain 5 tokens" << std::endl;
+          std::cerr << "readText(): The line was: " << std::string(line_begin, line_end) << std::endl;
+        }
+        return;
       }
-    }
-    else if(tokens[0].length() != kmer_length)
-    {
-      std::cerr << "readText(): Invalid kmer length: " << tokens[0].length()
-                << " (expected " << kmer_length << ")" << std::endl;
-      std::exit(EXIT_FAILURE);
-    }
+      if(!(block.setLength(line.length()))) { return; }
 
-    for(size_type successor = 4; successor < tokens.size(); successor++)
+      byte_type predecessors = KMer::chars(line.begin[2], line.end[2], this->alpha);
+      byte_type successors = KMer::chars(line.begin[3], line.end[3], this->alpha);
+      key_type key = Key::encode(this->alpha, line.begin[0], line.length(), predecessors, successors);
+      node_type from = Node::encode(line.begin[1], line.end[1]);
+      line.successors([&](const char* successor_begin, const char* successor_end)
+      {
+        block.kmers.push_back(KMer(key, from, Node::encode(successor_begin, successor_end)));
+      });
+    });
+    block.kmer_count = block.kmers.size();
+  }
+};
+
+// Checks that the kmer length of the block matches kmer_length and updates it.
+void
+checkLength(const TextBlock& block, size_type& kmer_length)
+{
+  if(block.kmer_length == InputGraph::UNKNOWN) { return; }
+  if(kmer_length == InputGraph::UNKNOWN)
+  {
+    kmer_length = block.kmer_length;
+    if(kmer_length == 0 || kmer_length > Key::MAX_LENGTH)
     {
-      kmers.push_back(KMer(tokens, alpha, successor));
+      std::cerr << "readText(): Invalid kmer length: " << kmer_length << std::endl;
+      std::exit(EXIT_FAILURE);
     }
   }
+  size_type invalid_length = (block.kmer_length != kmer_length ? block.kmer_length : block.invalid_length);
+  if(invalid_length != InputGraph::UNKNOWN)
+  {
+    std::cerr << "readText(): Invalid kmer length: " << invalid_length
+              << " (expected " << kmer_length << ")" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+size_type
+readText(std::istream& in, std::vector<KMer>& kmers, const Alphabet& alpha, bool append)
+{
+  if(!append) { sdsl::util::clear(kmers); }
+
+  size_type kmer_length = InputGraph::UNKNOWN;
+  parseText(in, KMerParser(alpha), [&](TextBlock& block)
+  {
+    checkLength(block, kmer_length);
+    kmers.insert(kmers.end(), block.kmers.begin(), block.kmers.end());
+    sdsl::util::clear(block.kmers);
+  });
 
   return kmer_length;
 }
@@ -237,30 +381,17 @@ GraphFileHeader::serialize(std::ostream& out)
 
 //------------------------------------------------------------------------------
 
-range_type
-parseKMer(const std::string& kmer_line)
+// Counts the kmers in a block of text without creating them.
+void
+countKMers(const char* block_begin, const char* block_end, TextBlock& block)
 {
-  std::string extensions;
-  range_type result(InputGraph::UNKNOWN, 0);
+  forEachLine(block_begin, block_end, [&](const char* line_begin, const char* line_end)
   {
-    std::string token;
-    std::istringstream ss(kmer_line);
-    if(!std::getline(ss, token, '\t')) { return result; }
-    result.first = token.length();  // kmer length
-    for(size_type i = 0; i < 3; i++)
-    {
-      if(!std::getline(ss, token, '\t')) { return result; }
-    }
-    if(!std::getline(ss, extensions, '\t')) { return result; }
-  }
-
-  {
-    std::string token;
-    std::istringstream ss(extensions);
-    while(std::getline(ss, token, ',')) { result.second++; }
-  }
-
-  return result;
+    KMerLine line;
+    if(!(line.tokenize(line_begin, line_end))) { return; }
+    if(!(block.setLength(line.length()))) { return; }
+    line.successors([&](const char*, const char*) { block.kmer_count++; });
+  });
 }
 
 /*
@@ -282,6 +413,29 @@ markSourceSinkNodes(std::vector<KMer>& kmers)
 
 //------------------------------------------------------------------------------
 
+KMerProducer
+streamProducer(const std::string& filename, bool binary_format, const Alphabet& alphabet)
+{
+  return [filename, binary_format, alphabet](std::vector<KMer>& kmers, size_type& kmer_length) -> bool
+  {
+    std::ifstream file;
+    if(filename != "-")
+    {
+      file.open(filename.c_str(), std::ios_base::binary);
+      if(!file)
+      {
+        std::cerr << "streamProducer(): Cannot open input " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+    std::istream& in = (filename == "-" ? std::cin : file);
+    kmer_length = (binary_format ? readBinary(in, kmers, true) : readText(in, kmers, alphabet, true));
+    return false;
+  };
+}
+
+//------------------------------------------------------------------------------
+
 InputGraph::InputGraph(const std::vector<std::string>& files, bool binary_format, const Alphabet& alphabet, const std::string& mapping_name) :
   filenames(files), lcp_name(), alpha(alphabet), binary(binary_format)
 {
@@ -299,6 +453,18 @@ InputGraph::InputGraph(size_type file_count, char** base_names, bool binary_form
   this->build(mapping_name);
 }
 
+InputGraph::InputGraph(const std::vector<KMerProducer>& kmer_producers, const std::vector<std::string>& names, const Alphabet& alphabet, const std::string& mapping_name) :
+  filenames(names), producers(kmer_producers), lcp_name(), alpha(alphabet), binary(false)
+{
+  if(this->producers.size() != this->filenames.size())
+  {
+    std::cerr << "InputGraph::InputGraph(): Expected " << this->producers.size() << " names for producers, got "
+              << this->filenames.size() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  this->build(mapping_name);
+}
+
 InputGraph::~InputGraph()
 {
   TempFile::remove(this->lcp_name);
@@ -310,8 +476,9 @@ InputGraph::build(const std::string& mapping_name)
   this->kmer_count = 0; this->kmer_length = UNKNOWN;
   this->sizes = std::vector<size_type>(this->files(), 0);
 
-  // Read the files and determine kmer_count, kmer_length.
-  for(size_type file = 0; file < this->files(); file++)
+  // Read the files and determine kmer_count, kmer_length. With streaming input, they
+  // are determined in consume().
+  for(size_type file = 0; file < this->files() && !(this->streaming()); file++)
   {
     std::ifstream input; this->open(input, file);
     if(this->binary)
@@ -328,16 +495,13 @@ InputGraph::build(const std::string& mapping_name)
     }
     else
     {
-      while(true)
+      parseText(input, countKMers, [&](const TextBlock& block)
       {
-        std::string line;
-        std::getline(input, line);
-        if(!input) { break; }
-        range_type temp = parseKMer(line);
-        this->setK(temp.first, file);
-        this->kmer_count += temp.second; this->sizes[file] += temp.second;
-      }
-
+        if(block.kmer_length == UNKNOWN) { return; }
+        this->setK(block.kmer_length, file);
+        if(block.invalid_length != UNKNOWN) { this->checkK(block.invalid_length, file); }
+        this->kmer_count += block.kmer_count; this->sizes[file] += block.kmer_count;
+      });
     }
     input.close();
   }
@@ -356,8 +520,15 @@ InputGraph::build(const std::string& mapping_name)
 
   if(Verbosity::level >= Verbosity::BASIC)
   {
-    std::cerr << "InputGraph::InputGraph(): " << this->size() << " kmers in "
-              << this->files() << " file(s)" << std::endl;
+    if(this->streaming())
+    {
+      std::cerr << "InputGraph::InputGraph(): Streaming input from " << this->files() << " producer(s)" << std::endl;
+    }
+    else
+    {
+      std::cerr << "InputGraph::InputGraph(): " << this->size() << " kmers in "
+                << this->files() << " file(s)" << std::endl;
+    }
   }
 }
 
@@ -420,6 +591,11 @@ InputGraph::read(std::vector<KMer>& kmers) const
 void
 InputGraph::read(std::vector<KMer>& kmers, size_type file, bool append) const
 {
+  if(this->streaming())
+  {
+    std::cerr << "InputGraph::read(): Cannot reread streaming input" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
   if(!append) { sdsl::util::clear(kmers); }
 
   std::ifstream input; this->open(input, file);
@@ -437,6 +613,41 @@ InputGraph::read(std::vector<KMer>& kmers, size_type file, bool append) const
   if(!append) { markSourceSinkNodes(kmers); }
 }
 
+void
+InputGraph::consume(std::vector<KMer>& kmers, size_type file)
+{
+  if(!(this->streaming())) { this->read(kmers, file, false); return; }
+  if(file >= this->files())
+  {
+    std::cerr << "InputGraph::consume(): Invalid producer number: " << file << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  if(!(this->producers[file]))
+  {
+    std::cerr << "InputGraph::consume(): Producer " << this->filenames[file] << " has already been consumed" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  sdsl::util::clear(kmers);
+  bool more = true;
+  while(more)
+  {
+    size_type new_k = UNKNOWN;
+    more = this->producers[file](kmers, new_k);
+    if(new_k != UNKNOWN) { this->setK(new_k, file); }
+  }
+  this->producers[file] = nullptr;
+  this->sizes[file] = kmers.size(); this->kmer_count += kmers.size();
+
+  if(Verbosity::level >= Verbosity::FULL)
+  {
+    std::cerr << "InputGraph::consume(): Read " << kmers.size() << " " << this->k() << "-mers"
+              << " from " << this->filenames[file] << std::endl;
+  }
+
+  markSourceSinkNodes(kmers);
+}
+
 void
 InputGraph::readKeys(std::vector<key_type>& keys) const
 {
@@ -530,10 +741,18 @@ GCSAHeader::load(std::istream& in)
   sdsl::read_member(this->flags, in);
 }
 
+bool
+GCSAHeader::check() const
+{
+  if(this->tag == TAG && this->version == COMPATIBLE_VERSION && this->flags == 0) { return true; }
+  return this->check(VERSION);
+}
+
 bool
 GCSAHeader::check(uint32_t expected_version) const
 {
-  return (this->tag == TAG && this->version == expected_version && this->flags == 0);
+  if(this->tag != TAG || this->version != expected_version) { return false; }
+  return ((this->flags & FLAG_MASK) == this->flags);
 }
 
 bool
@@ -560,7 +779,11 @@ std::ostream& operator<<(std::ostream& stream, const GCSAHeader& header)
 {
   return stream << "GCSA version " << header.version << ": "
                 << header.path_nodes << " path nodes, "
-                << header.edges << " edges, order " << header.order;
+                << header.edges << " edges, order " << header.order
+                << (header.get(GCSAHeader::PACKED_BWT) ? ", packed BWT" : "")
+                << (header.get(GCSAHeader::RUN_LENGTH_BWT) ? ", run-length BWT" : "")
+                << (header.get(GCSAHeader::COMBINED_SPARSE) ? ", combined sparse" : "")
+                << (header.get(GCSAHeader::MAPPABLE) ? ", mappable" : "");
 }
 
 //------------------------------------------------------------------------------
@@ -596,10 +819,18 @@ LCPHeader::load(std::istream& in)
   sdsl::read_member(this->flags, in);
 }
 
+bool
+LCPHeader::check() const
+{
+  if(this->tag != TAG || this->version < MIN_VERSION || this->version > VERSION) { return false; }
+  return ((this->flags & FLAG_MASK) == this->flags);
+}
+
 bool
 LCPHeader::check(uint32_t expected_version) const
 {
-  return (this->tag == TAG && this->version == expected_version && this->flags == 0);
+  if(this->tag != TAG || this->version != expected_version) { return false; }
+  return ((this->flags & FLAG_MASK) == this->flags);
 }
 
 bool
@@ -625,7 +856,8 @@ std::ostream& operator<<(std::ostream& stream, const LCPHeader& header)
 {
   return stream << "LCP version " << header.version
                 << ": array size " << header.size
-                << ", branching factor " << header.branching;
+                << ", branching factor " << header.branching
+                << (header.get(LCPHeader::MAPPABLE) ? ", mappable" : "");
 }
 
 //------------------------------------------------------------------------------
@@ -28,6 +28,7 @@
 #include <gcsa/path_graph.h>
 
 #include <random>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace gcsa
@@ -43,12 +44,13 @@ const std::string GCSA::EXTENSION = ".gcsa";
 
 GCSA::GCSA() :
   header(), alpha(),
-  fast_bwt(this->alpha.sigma), fast_rank(this->alpha.sigma),
-  sparse_bwt(this->alpha.sigma), sparse_rank(this->alpha.sigma),
+  fast_bwt(this->alpha.sigma), fast_rank(this->alpha.sigma), packed_bwt(), run_length_bwt(),
+  sparse_bwt(this->alpha.sigma), sparse_rank(this->alpha.sigma), sparse_combined(),
   edges(), edge_rank(),
   sampled_paths(), sampled_path_rank(),
-  stored_samples(), samples(), sample_select(),
-  extra_pointers(), redundant_pointers()
+  stored_samples(), sample_values(), samples(), sample_select(),
+  extra_pointers(), redundant_pointers(),
+  mapping()
 {
 }
 
@@ -76,9 +78,12 @@ GCSA::swap(GCSA& another)
 
     this->fast_bwt.swap(another.fast_bwt);
     this->fast_rank.swap(another.fast_rank);
+    this->packed_bwt.swap(another.packed_bwt);
+    this->run_length_bwt.swap(another.run_length_bwt);
 
     this->sparse_bwt.swap(another.sparse_bwt);
     this->sparse_rank.swap(another.sparse_rank);
+    this->sparse_combined.swap(another.sparse_combined);
 
     this->edges.swap(another.edges);
     sdsl::util::swap_support(this->edge_rank, another.edge_rank, &(this->edges), &(another.edges));
@@ -87,13 +92,16 @@ GCSA::swap(GCSA& another)
     sdsl::util::swap_support(this->sampled_path_rank, another.sampled_path_rank, &(this->sampled_paths), &(another.sampled_paths));
 
     this->stored_samples.swap(another.stored_samples);
+    std::swap(this->sample_values, another.sample_values);
     this->samples.swap(another.samples);
     sdsl::util::swap_support(this->sample_select, another.sample_select, &(this->samples), &(another.samples));
 
     this->extra_pointers.swap(another.extra_pointers);
     this->redundant_pointers.swap(another.redundant_pointers);
 
+    this->mapping.swap(another.mapping);
     this->setVectors();
+    another.setVectors();
   }
 }
 
@@ -114,9 +122,12 @@ GCSA::operator=(GCSA&& source)
 
     this->fast_bwt = std::move(source.fast_bwt);
     this->fast_rank = std::move(source.fast_rank);
+    this->packed_bwt = std::move(source.packed_bwt);
+    this->run_length_bwt = std::move(source.run_length_bwt);
 
     this->sparse_bwt = std::move(source.sparse_bwt);
     this->sparse_rank = std::move(source.sparse_rank);
+    this->sparse_combined = std::move(source.sparse_combined);
 
     this->edges = std::move(source.edges);
     this->edge_rank = std::move(source.edge_rank);
@@ -125,12 +136,14 @@ GCSA::operator=(GCSA&& source)
     this->sampled_path_rank = std::move(source.sampled_path_rank);
 
     this->stored_samples = std::move(source.stored_samples);
+    this->sample_values = source.sample_values;
     this->samples = std::move(source.samples);
     this->sample_select = std::move(source.sample_select);
 
     this->extra_pointers = std::move(source.extra_pointers);
     this->redundant_pointers = std::move(source.redundant_pointers);
 
+    this->mapping = std::move(source.mapping);
     this->setVectors();
   }
   return *this;
@@ -145,14 +158,27 @@ GCSA::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string nam
   written_bytes += this->header.serialize(out, child, "header");
   written_bytes += this->alpha.serialize(out, child, "alpha");
 
+  // Block arrays start at cache line boundaries, or at page boundaries in mappable files.
+  size_type alignment = (this->header.get(GCSAHeader::MAPPABLE) ? MAPPED_ALIGNMENT : RankBitVector::ALIGNMENT);
   for(size_type comp = 0; comp < this->alpha.sigma; comp++)
   {
-    written_bytes += this->fast_bwt[comp].serialize(out, child, "fast_bwt");
+    written_bytes += this->fast_bwt[comp].serialize(out, child, "fast_bwt", written_bytes, alignment);
   }
   for(size_type comp = 0; comp < this->alpha.sigma; comp++)
   {
     written_bytes += this->fast_rank[comp].serialize(out, child, "fast_rank");
   }
+  if(this->packed())
+  {
+    written_bytes += this->packed_bwt.serialize(out, child, "packed_bwt", written_bytes, alignment);
+  }
+  if(this->runLength())
+  {
+    for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
+    {
+      written_bytes += this->run_length_bwt[comp].serialize(out, child, "run_length_bwt");
+    }
+  }
 
   for(size_type comp = 0; comp < this->alpha.sigma; comp++)
   {
@@ -162,14 +188,34 @@ GCSA::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string nam
   {
     written_bytes += this->sparse_rank[comp].serialize(out, child, "sparse_rank");
   }
+  if(this->combinedSparse())
+  {
+    written_bytes += this->sparse_combined.serialize(out, child, "sparse_combined", written_bytes, alignment);
+  }
 
-  written_bytes += this->edges.serialize(out, child, "edges");
+  written_bytes += this->edges.serialize(out, child, "edges", written_bytes, alignment);
   written_bytes += this->edge_rank.serialize(out, child, "edge_rank");
 
-  written_bytes += this->sampled_paths.serialize(out, child, "sampled_paths");
+  written_bytes += this->sampled_paths.serialize(out, child, "sampled_paths", written_bytes, alignment);
   written_bytes += this->sampled_path_rank.serialize(out, child, "sampled_path_rank");
 
-  written_bytes += this->stored_samples.serialize(out, child, "stored_samples");
+  if(this->header.get(GCSAHeader::MAPPABLE))
+  {
+    sdsl::structure_tree_node* samples_node =
+      sdsl::structure_tree::add_child(child, "stored_samples", "mappable_int_vector");
+    size_type sample_bytes = 0;
+    size_type count = this->sample_values.size(), width = this->sample_values.width();
+    sample_bytes += sdsl::write_member(count, out, samples_node, "size");
+    sample_bytes += sdsl::write_member(width, out, samples_node, "width");
+    sample_bytes += serializeWords(this->sample_values.data(), (count * width + WORD_BITS - 1) / WORD_BITS, out,
+                                   written_bytes + sample_bytes, samples_node, "data");
+    sdsl::structure_tree::add_size(samples_node, sample_bytes);
+    written_bytes += sample_bytes;
+  }
+  else
+  {
+    written_bytes += this->stored_samples.serialize(out, child, "stored_samples");
+  }
   written_bytes += this->samples.serialize(out, child, "samples");
   written_bytes += this->sample_select.serialize(out, child, "sample_select");
 
@@ -183,28 +229,97 @@ GCSA::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string nam
 void
 GCSA::load(std::istream& in)
 {
+  this->mapping.reset();
+  this->load(in, nullptr);
+}
+
+bool
+GCSA::map(const std::string& filename)
+{
+  std::shared_ptr<MappedFile> file(new MappedFile(filename));
+  if(!(file->isOpen())) { return false; }
+
+  MappedStreamBuffer buffer(*file);
+  std::istream in(&buffer);
+  this->mapping = file;
+  this->load(in, file.get());
+  if(!in)
+  {
+    std::cerr << "GCSA::map(): Cannot load the index from " << filename << std::endl;
+    *this = GCSA();
+    return false;
+  }
+  return true;
+}
+
+void
+GCSA::load(std::istream& in, const MappedFile* file)
+{
+  // Version 3 without flags has the same body as version 5 without flags. Other older
+  // versions have a different body, so they cannot be loaded.
   this->header.load(in);
   if(!(this->header.check()))
   {
     std::cerr << "GCSA::load(): Invalid header: " << this->header << std::endl;
+    if(this->header.tag == GCSAHeader::TAG && this->header.version < GCSAHeader::VERSION)
+    {
+      std::cerr << "GCSA::load(): The index must be rebuilt with this version of GCSA" << std::endl;
+    }
+    *this = GCSA();
+    in.setstate(std::ios_base::failbit);
+    return;
   }
   this->alpha.load(in);
 
   this->fast_bwt.resize(this->alpha.sigma); this->fast_rank.resize(this->alpha.sigma);
-  for(size_type comp = 0; comp < this->alpha.sigma; comp++) { this->fast_bwt[comp].load(in); }
+  for(size_type comp = 0; comp < this->alpha.sigma; comp++) { this->fast_bwt[comp].load(in, this->rankVectors(), file); }
   for(size_type comp = 0; comp < this->alpha.sigma; comp++) { this->fast_rank[comp].load(in, &(this->fast_bwt[comp])); }
+  if(this->packed()) { this->packed_bwt.load(in, file); }
+  else { this->packed_bwt = PackedBWT(); }
+  this->run_length_bwt.clear();
+  if(this->runLength())
+  {
+    this->run_length_bwt.resize(this->alpha.fast_chars + 1);
+    for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++) { this->run_length_bwt[comp].load(in); }
+  }
 
   this->sparse_bwt.resize(this->alpha.sigma); this->sparse_rank.resize(this->alpha.sigma);
   for(size_type comp = 0; comp < this->alpha.sigma; comp++) { this->sparse_bwt[comp].load(in); }
   for(size_type comp = 0; comp < this->alpha.sigma; comp++) { this->sparse_rank[comp].load(in, &(this->sparse_bwt[comp])); }
+  if(this->combinedSparse()) { this->sparse_combined.load(in, file); }
+  else { this->sparse_combined = SparseBWT(); }
 
-  this->edges.load(in);
+  this->edges.load(in, this->rankVectors(), file);
   this->edge_rank.load(in, &(this->edges));
 
-  this->sampled_paths.load(in);
+  this->sampled_paths.load(in, this->rankVectors(), file);
   this->sampled_path_rank.load(in, &(this->sampled_paths));
 
-  this->stored_samples.load(in);
+  if(this->header.get(GCSAHeader::MAPPABLE))
+  {
+    size_type count = 0, width = 0;
+    sdsl::read_member(count, in);
+    sdsl::read_member(width, in);
+    size_type words = loadWordCount(in);
+    const std::uint64_t* mapped = (file != nullptr ? mapWords(in, *file, words) : nullptr);
+    if(mapped != nullptr)
+    {
+      sdsl::util::clear(this->stored_samples);
+      this->sample_values = IntVectorView(mapped, count, width);
+    }
+    else
+    {
+      this->stored_samples = sdsl::int_vector<0>(count, 0, width);
+      loadWords(in, this->stored_samples.data(), words);
+      this->sample_values = IntVectorView(this->stored_samples);
+    }
+  }
+  else
+  {
+    this->stored_samples.load(in);
+    this->sample_values = IntVectorView(this->stored_samples);
+  }
+  HugePages::advise(this->stored_samples.data(), this->stored_samples.capacity() / BYTE_BITS);
   this->samples.load(in);
   this->sample_select.load(in, &(this->samples));
 
@@ -220,9 +335,12 @@ GCSA::copy(const GCSA& source)
 
   this->fast_bwt = source.fast_bwt;
   this->fast_rank = source.fast_rank;
+  this->packed_bwt = source.packed_bwt;
+  this->run_length_bwt = source.run_length_bwt;
 
   this->sparse_bwt = source.sparse_bwt;
   this->sparse_rank = source.sparse_rank;
+  this->sparse_combined = source.sparse_combined;
 
   this->edges = source.edges;
   this->edge_rank = source.edge_rank;
@@ -231,12 +349,15 @@ GCSA::copy(const GCSA& source)
   this->sampled_path_rank = source.sampled_path_rank;
 
   this->stored_samples = source.stored_samples;
+  HugePages::advise(this->stored_samples.data(), this->stored_samples.capacity() / BYTE_BITS);
+  this->sample_values = source.sample_values;
   this->samples = source.samples;
   this->sample_select = source.sample_select;
 
   this->extra_pointers = source.extra_pointers;
   this->redundant_pointers = source.redundant_pointers;
 
+  this->mapping = source.mapping;
   this->setVectors();
 }
 
@@ -254,6 +375,11 @@ GCSA::setVectors()
   this->sampled_path_rank.set_vector(&(this->sampled_paths));
 
   this->sample_select.set_vector(&(this->samples));
+
+  if(!(this->mapping != nullptr && this->header.get(GCSAHeader::MAPPABLE)))
+  {
+    this->sample_values = IntVectorView(this->stored_samples);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -270,7 +396,10 @@ struct MergedGraphReader
   const sdsl::int_vector<0>*      last_char;
 
   void init(const MergedGraph& graph, const DeBruijnGraph* _mapper, const sdsl::int_vector<0>* _last_char);
-  void init(const MergedGraph& graph, size_type comp);
+
+  // Start from paths[_path] with from_nodes[_from] as the first additional start node.
+  void init(const MergedGraph& graph, size_type _path, size_type _from,
+    const DeBruijnGraph* _mapper, const sdsl::int_vector<0>* _last_char);
   void close();
 
   void seek();
@@ -282,12 +411,14 @@ struct MergedGraphReader
     this->seek();
   }
 
-  void predecessor(comp_type comp, PathLabel& first, PathLabel& last);
+  template<class Label>
+  void predecessor(comp_type comp, Label& first, Label& last);
 
   /*
     Does paths[path + offset] intersect with the given range of labels?
   */
-  bool intersect(const PathLabel& first, const PathLabel& last, size_type offset);
+  template<class Label>
+  bool intersect(const Label& first, const Label& last, size_type offset);
 
   void fromNodes(std::vector<node_type>& results, const NodeMapping& mapping);
 };
@@ -308,18 +439,19 @@ MergedGraphReader::init(const MergedGraph& graph,
 }
 
 void
-MergedGraphReader::init(const MergedGraph& graph, size_type comp)
+MergedGraphReader::init(const MergedGraph& graph, size_type _path, size_type _from,
+  const DeBruijnGraph* _mapper, const sdsl::int_vector<0>* _last_char)
 {
   this->paths.open(graph.path_name);
   this->labels.open(graph.rank_name);
   this->from_nodes.open(graph.from_name);
 
-  this->path = graph.next[comp];
-  this->from = graph.next_from[comp];
+  this->path = _path;
+  this->from = _from;
   this->seek();
 
-  this->mapper = nullptr;
-  this->last_char = nullptr;
+  this->mapper = _mapper;
+  this->last_char = _last_char;
 }
 
 void
@@ -345,8 +477,9 @@ MergedGraphReader::seek()
   this->from_nodes.seek(this->from);
 }
 
+template<class Label>
 void
-MergedGraphReader::predecessor(comp_type comp, PathLabel& first, PathLabel& last)
+MergedGraphReader::predecessor(comp_type comp, Label& first, Label& last)
 {
   const PathNode& curr = this->paths[this->path];
   size_type i = 0, j = curr.pointer();
@@ -370,7 +503,7 @@ MergedGraphReader::predecessor(comp_type comp, PathLabel& first, PathLabel& last
     last_comp = (*(this->last_char))[this->labels[j + 1]];
     i++;
   }
-  if(i < PathLabel::LABEL_LENGTH)
+  if(i < Label::LABEL_LENGTH)
   {
     first.label[i] = this->mapper->node_rank(this->mapper->alpha.C[first_comp]);
     last.label[i] = this->mapper->node_rank(this->mapper->alpha.C[last_comp + 1]) - 1;
@@ -378,42 +511,45 @@ MergedGraphReader::predecessor(comp_type comp, PathLabel& first, PathLabel& last
   }
 
   // Pad the labels.
-  while(i < PathLabel::LABEL_LENGTH)
+  while(i < Label::LABEL_LENGTH)
   {
-    first.label[i] = 0; last.label[i] = PathLabel::NO_RANK; i++;
+    first.label[i] = 0; last.label[i] = Label::NO_RANK; i++;
   }
 }
 
-inline PathLabel
-firstLabel(const PathNode& path, ReadBuffer<PathNode::rank_type>& labels)
+template<class Label, class ArrayType>
+inline Label
+firstLabel(const PathNode& path, ArrayType& labels)
 {
-  PathLabel res; res.first = true;
-  size_type limit = std::min(path.order(), PathLabel::LABEL_LENGTH);
+  Label res; res.first = true;
+  size_type limit = std::min(path.order(), Label::LABEL_LENGTH);
   for(size_type i = 0; i < limit; i++) { res.label[i] = path.firstLabel(i, labels); }
-  for(size_type i = limit; i < PathLabel::LABEL_LENGTH; i++) { res.label[i] = 0; }
+  for(size_type i = limit; i < Label::LABEL_LENGTH; i++) { res.label[i] = 0; }
   return res;
 }
 
-inline PathLabel
-lastLabel(const PathNode& path, ReadBuffer<PathNode::rank_type>& labels)
+template<class Label, class ArrayType>
+inline Label
+lastLabel(const PathNode& path, ArrayType& labels)
 {
-  PathLabel res; res.first = false;
-  size_type limit = std::min(path.order(), PathLabel::LABEL_LENGTH);
+  Label res; res.first = false;
+  size_type limit = std::min(path.order(), Label::LABEL_LENGTH);
   for(size_type i = 0; i < limit; i++) { res.label[i] = path.lastLabel(i, labels); }
-  for(size_type i = limit; i < PathLabel::LABEL_LENGTH; i++) { res.label[i] = PathLabel::NO_RANK; }
+  for(size_type i = limit; i < Label::LABEL_LENGTH; i++) { res.label[i] = Label::NO_RANK; }
   return res;
 }
 
 /*
   Does the path node intersect with the given range of labels?
 */
+template<class Label>
 bool
-MergedGraphReader::intersect(const PathLabel& first, const PathLabel& last, size_type offset)
+MergedGraphReader::intersect(const Label& first, const Label& last, size_type offset)
 {
-  PathLabel my_first = firstLabel(this->paths[this->path + offset], this->labels);
+  Label my_first = firstLabel<Label>(this->paths[this->path + offset], this->labels);
   if(my_first <= first)
   {
-    PathLabel my_last = lastLabel(this->paths[this->path + offset], this->labels);
+    Label my_last = lastLabel<Label>(this->paths[this->path + offset], this->labels);
     return (first <= my_last);
   }
   else
@@ -441,12 +577,519 @@ MergedGraphReader::fromNodes(std::vector<node_type>& results, const NodeMapping&
 
 //------------------------------------------------------------------------------
 
-GCSA::GCSA(InputGraph& graph, const ConstructionParameters& parameters) :
-  GCSA()
+/*
+  Random access to the MergedGraph files without buffering. Used for positioning the
+  readers at the start of each partition in parallel construction.
+*/
+struct MergedGraphSearcher
 {
-  double start = readTimer();
+  std::ifstream paths, labels, from_nodes;
+  size_type     path_count, from_count;
+
+  explicit MergedGraphSearcher(const MergedGraph& graph);
+  ~MergedGraphSearcher();
+
+  PathNode path(size_type i);
+  range_type fromNode(size_type i);
+
+  inline PathNode::rank_type operator[] (size_type i)
+  {
+    PathNode::rank_type result = 0;
+    this->labels.seekg(i * sizeof(PathNode::rank_type), std::ios_base::beg);
+    if(!DiskIO::read(this->labels, &result)) { this->readError(); }
+    return result;
+  }
+
+  // Returns the first path >= low intersecting the range starting with the given label.
+  template<class Label>
+  size_type findPath(const Label& first, size_type low);
+
+  // Returns the first additional start node for a path >= path_id.
+  size_type findFrom(size_type path_id);
+
+  void readError();
+
+  MergedGraphSearcher(const MergedGraphSearcher&) = delete;
+  MergedGraphSearcher& operator= (const MergedGraphSearcher&) = delete;
+};
+
+MergedGraphSearcher::MergedGraphSearcher(const MergedGraph& graph) :
+  paths(graph.path_name, std::ios_base::binary),
+  labels(graph.rank_name, std::ios_base::binary),
+  from_nodes(graph.from_name, std::ios_base::binary),
+  path_count(graph.size()), from_count(graph.extra())
+{
+  if(!(this->paths) || !(this->labels) || !(this->from_nodes))
+  {
+    std::cerr << "MergedGraphSearcher::MergedGraphSearcher(): Cannot open the MergedGraph files" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+MergedGraphSearcher::~MergedGraphSearcher()
+{
+  this->paths.close(); this->labels.close(); this->from_nodes.close();
+}
+
+PathNode
+MergedGraphSearcher::path(size_type i)
+{
+  PathNode result;
+  this->paths.seekg(i * sizeof(PathNode), std::ios_base::beg);
+  if(!DiskIO::read(this->paths, &result)) { this->readError(); }
+  return result;
+}
+
+range_type
+MergedGraphSearcher::fromNode(size_type i)
+{
+  range_type result;
+  this->from_nodes.seekg(i * sizeof(range_type), std::ios_base::beg);
+  if(!DiskIO::read(this->from_nodes, &result)) { this->readError(); }
+  return result;
+}
+
+template<class Label>
+size_type
+MergedGraphSearcher::findPath(const Label& first, size_type low)
+{
+  size_type high = this->path_count;
+  while(low < high)
+  {
+    size_type mid = low + (high - low) / 2;
+    if(lastLabel<Label>(this->path(mid), *this) < first) { low = mid + 1; }
+    else { high = mid; }
+  }
+  return low;
+}
+
+size_type
+MergedGraphSearcher::findFrom(size_type path_id)
+{
+  size_type low = 0, high = this->from_count;
+  while(low < high)
+  {
+    size_type mid = low + (high - low) / 2;
+    if(this->fromNode(mid).first < path_id) { low = mid + 1; }
+    else { high = mid; }
+  }
+  return low;
+}
+
+void
+MergedGraphSearcher::readError()
+{
+  std::cerr << "MergedGraphSearcher: Unexpected EOF" << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  Construction is partitioned into ranges of paths [start, limit) that are processed by
+  different threads. The boundaries are multiples of 64, so that the threads never
+  write to the same word in the shared bitvectors.
+
+  The sequential algorithm starts the predecessor reader for comp at next[comp] and
+  advances it by at most one path for each edge. A partition with exact start positions
+  (start_paths) does the same. Other partitions guess the position of the reader for
+  comp by binary search, when the first edge with that comp is found. The guess is
+  verified after the parallel pass, when the positions at the end of the previous
+  partition are known, and the partition is rebuilt with exact start positions if the
+  sequential algorithm would have used a different path for any first edge. The guess
+  fails on some repetitive graphs, where the intersection test is not monotone.
+
+  Edges with the same comp go to paths in sorted order, so each partition produces a
+  contiguous sequence of the final edges bitvector for each comp. The last edge in the
+  sequence is marked as the last edge of its path; this must be fixed if the next
+  sequence starts with the same path.
+*/
+struct BuildPartition
+{
+  size_type               start, limit;
+  std::vector<size_type>  start_paths;                // Exact reader positions for each comp, if known.
+
+  std::vector<size_type>  counts;                     // Edges by comp.
+  std::vector<sdsl::bit_vector> edges;                // The edges bitvector for each comp.
+  std::vector<size_type>  first_target, last_target;  // First/last paths for each comp.
+
+  // The first edge with comp went to first_target[comp]. A sequential reader would have
+  // done the same from first_target[comp] if hit_target[comp] and from first_target[comp] - 1
+  // if miss_before[comp].
+  std::vector<bool>       hit_target, miss_before;
+
+  std::vector<node_type>  samples;
+  std::vector<size_type>  sample_ends;                // Sample ranges of sampled paths.
+  size_type               sample_bits;
+
+  BuildPartition();
+
+  inline bool exact() const { return !(this->start_paths.empty()); }
+
+  // Would a sequential reader at reader_paths have produced the same edges?
+  bool consistent(const std::vector<size_type>& reader_paths) const;
+
+  // Chooses the label type by the number of doubling steps in the graph.
+  void build(const MergedGraph& graph, const DeBruijnGraph& mapper, const sdsl::int_vector<0>& last_char,
+    const NodeMapping& mapping, size_type sample_period,
+    std::vector<sdsl::bit_vector>& bwt, sdsl::bit_vector& sampled_positions);
+
+  template<class Label>
+  void buildPaths(const MergedGraph& graph, const DeBruijnGraph& mapper, const sdsl::int_vector<0>& last_char,
+    const NodeMapping& mapping, size_type sample_period,
+    std::vector<sdsl::bit_vector>& bwt, sdsl::bit_vector& sampled_positions);
+};
+
+BuildPartition::BuildPartition() :
+  start(0), limit(0), sample_bits(0)
+{
+}
+
+bool
+BuildPartition::consistent(const std::vector<size_type>& reader_paths) const
+{
+  if(this->exact()) { return (this->start_paths == reader_paths); }
+  for(size_type comp = 0; comp < this->counts.size(); comp++)
+  {
+    if(this->counts[comp] == 0) { continue; }
+    if(this->first_target[comp] == reader_paths[comp] && this->hit_target[comp]) { continue; }
+    if(this->first_target[comp] == reader_paths[comp] + 1 && this->miss_before[comp]) { continue; }
+    return false;
+  }
+  return true;
+}
+
+/*
+  The predecessor labels have space for the path label and the first character of the
+  following kmer.
+*/
+struct BuildJob
+{
+  BuildPartition&               partition;
+  const MergedGraph&            graph;
+  const DeBruijnGraph&          mapper;
+  const sdsl::int_vector<0>&    last_char;
+  const NodeMapping&            mapping;
+  size_type                     sample_period;
+  std::vector<sdsl::bit_vector>& bwt;
+  sdsl::bit_vector&             sampled_positions;
+
+  template<size_type LENGTH>
+  void run()
+  {
+    this->partition.buildPaths<SizedLabel<LENGTH + 1>>(this->graph, this->mapper, this->last_char,
+      this->mapping, this->sample_period, this->bwt, this->sampled_positions);
+  }
+};
+
+void
+BuildPartition::build(const MergedGraph& graph, const DeBruijnGraph& mapper, const sdsl::int_vector<0>& last_char,
+  const NodeMapping& mapping, size_type sample_period,
+  std::vector<sdsl::bit_vector>& bwt, sdsl::bit_vector& sampled_positions)
+{
+  BuildJob job { *this, graph, mapper, last_char, mapping, sample_period, bwt, sampled_positions };
+  withLabelLength(graph.step(), job);
+}
+
+template<class Label>
+void
+BuildPartition::buildPaths(const MergedGraph& graph, const DeBruijnGraph& mapper, const sdsl::int_vector<0>& last_char,
+  const NodeMapping& mapping, size_type sample_period,
+  std::vector<sdsl::bit_vector>& bwt, sdsl::bit_vector& sampled_positions)
+{
+  size_type sigma = mapper.alpha.sigma;
+  this->counts = std::vector<size_type>(sigma, 0);
+  this->edges = std::vector<sdsl::bit_vector>(sigma);
+  this->first_target = std::vector<size_type>(sigma, 0);
+  this->last_target = std::vector<size_type>(sigma, 0);
+  this->hit_target = std::vector<bool>(sigma, false);
+  this->miss_before = std::vector<bool>(sigma, false);
+  sdsl::util::clear(this->samples); sdsl::util::clear(this->sample_ends);
+  this->sample_bits = 0;
+  if(this->start >= this->limit) { return; }
+
+  // Clear the sampled positions in case we are rebuilding the partition.
+  for(size_type i = this->start; i < this->limit; i += 64)
+  {
+    sampled_positions.set_int(i, 0, std::min((size_type)64, this->limit - i));
+  }
+
+  MergedGraphSearcher searcher(graph);
+  std::vector<MergedGraphReader> reader(sigma + 1);
+  reader[0].init(graph, this->start, searcher.findFrom(this->start), &mapper, &last_char);
+
+  Label first, last;
+  std::vector<node_type> pred_from, curr_from;
+  for(size_type i = this->start; i < this->limit; i++, reader[0].advance())
+  {
+    // Find the predecessors.
+    size_type indegree = 0, pred_comp = 0;
+    bool sample_this = false;
+    for(size_type comp = 0; comp < sigma; comp++)
+    {
+      if(!(reader[0].paths[reader[0].path].hasPredecessor(comp))) { continue; }
+
+      // Find the predecessor of paths[i] with comp and the path intersecting it.
+      reader[0].predecessor(comp, first, last);
+      if(this->counts[comp] == 0 && this->exact())
+      {
+        size_type reader_start = this->start_paths[comp];
+        reader[comp + 1].init(graph, reader_start, searcher.findFrom(reader_start), nullptr, nullptr);
+        if(!(reader[comp + 1].intersect(first, last, 0))) { reader[comp + 1].advance(); }
+        this->first_target[comp] = reader[comp + 1].path;
+        this->edges[comp] = sdsl::bit_vector(this->limit - this->start, 0);
+      }
+      else if(this->counts[comp] == 0)
+      {
+        size_type target = std::min(searcher.findPath(first, graph.next[comp]), graph.size() - 1);
+        size_type reader_start = (target > graph.next[comp] ? target - 1 : target);
+        reader[comp + 1].init(graph, reader_start, searcher.findFrom(reader_start), nullptr, nullptr);
+        if(target > reader_start)
+        {
+          this->miss_before[comp] = !(reader[comp + 1].intersect(first, last, 0));
+          reader[comp + 1].advance();
+        }
+        this->hit_target[comp] = (target + 1 >= graph.size() || reader[comp + 1].intersect(first, last, 0));
+        this->first_target[comp] = target;
+        this->edges[comp] = sdsl::bit_vector(this->limit - this->start, 0);
+      }
+      else if(!(reader[comp + 1].intersect(first, last, 0)))
+      {
+        reader[comp + 1].advance();
+        this->edges[comp][this->counts[comp] - 1] = 1;
+      }
+
+      // Add the edge.
+      bwt[comp][i] = 1; this->counts[comp]++;
+      indegree++;
+      pred_comp = comp; // For sampling.
+    }
+
+    /*
+      Simple cases for sampling the node:
+      - multiple predecessors
+      - at the beginning of the source node with no real predecessors
+      - if a from node is divisible by the sample period
+    */
+    reader[0].fromNodes(curr_from, mapping);
+    if(indegree > 1) { sample_this = true; }
+    if(reader[0].paths[reader[0].path].hasPredecessor(Alphabet::SINK_COMP)) { sample_this = true; }
+    for(size_type k = 0; k < curr_from.size(); k++)
+    {
+      if(curr_from[k] % sample_period == 0) { sample_this = true; break; }
+    }
+
+    // Sample if the start nodes cannot be derived from the only predecessor. Every path in
+    // a valid graph has a predecessor, as the source node follows the sink node.
+    if(indegree == 0) { sample_this = true; }
+    if(!sample_this)
+    {
+      reader[pred_comp + 1].fromNodes(pred_from, mapping);
+      if(pred_from.size() != curr_from.size()) { sample_this = true; }
+      else
+      {
+        for(size_type k = 0; k < curr_from.size(); k++)
+        {
+          if(curr_from[k] != pred_from[k] + 1) { sample_this = true; break; }
+        }
+      }
+    }
+
+    // Store the samples.
+    if(sample_this)
+    {
+      sampled_positions[i] = 1;
+      for(size_type k = 0; k < curr_from.size(); k++)
+      {
+        this->sample_bits = std::max(this->sample_bits, bit_length(curr_from[k]));
+        this->samples.push_back(curr_from[k]);
+      }
+      this->sample_ends.push_back(this->samples.size());
+    }
+  }
+
+  for(size_type comp = 0; comp < sigma; comp++)
+  {
+    if(this->counts[comp] == 0) { continue; }
+    this->last_target[comp] = reader[comp + 1].path;
+    this->edges[comp][this->counts[comp] - 1] = 1;
+    this->edges[comp].resize(this->counts[comp]);
+  }
+  for(size_type i = 0; i < reader.size(); i++) { reader[i].close(); }
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  Builds the arrays used for counting queries.
+
+  We traverse the ST in inorder using the LCP array. For each internal node, we
+  record the LCP value and the first and the last times (positions) we have
+  encountered that value within the subtree. If we have encountered the current
+  from node before, the LCA of the previous and current occurrences is the
+  highest ST node we have encountered after the previous occurrence. We then
+  increment the redundant array at the first encounter with that node.
+
+  The traversal is partitioned in the same way as construction. A sequential pass
+  over the LCP array determines the stack at the start of each partition. Each
+  partition resolves the occurrences of from nodes it has already seen, and the
+  first occurrences are resolved sequentially in the end, when the previous
+  occurrences are known. Between the start of the partition and the first occurrence,
+  only the top node remaining from the initial stack can have been updated. Hence it
+  is enough to remember how much of the initial stack remains, whether the top was
+  updated, and the first time of the next node in the stack.
+
+  The counter arrays are not thread-safe, so the increments are buffered.
+
+  Invariant: The previous occurrence of from node x was at path prev_occ[from_rank(x)] - 1.
+*/
+struct CountPartition
+{
+  struct FirstOccurrence
+  {
+    size_type rank, depth, next_time;
+    bool      updated;
+  };
+
+  size_type                     start, limit;
+  std::vector<size_type>        node_lcp, first_time, last_time;  // The stack at start.
+
+  std::vector<range_type>       occurrences;  // (path, additional from nodes)
+  std::vector<size_type>        redundant;
+  std::vector<FirstOccurrence>  first_occ;
+  std::vector<range_type>       last_occ;     // (from_rank, path + 1)
+
+  CountPartition();
+
+  // Initializes the stacks at the start of each partition.
+  static void seed(const MergedGraph& graph, std::vector<CountPartition>& partitions);
+
+  void count(const MergedGraph& graph, const NodeMapping& mapping, const sdsl::sd_vector<>::rank_1_type& from_rank);
+
+  // Must be called for the partitions in order.
+  void resolve(sdsl::int_vector<0>& prev_occ, CounterArray& occurrences, CounterArray& redundant);
+};
+
+CountPartition::CountPartition() :
+  start(0), limit(0)
+{
+}
+
+void
+CountPartition::seed(const MergedGraph& graph, std::vector<CountPartition>& partitions)
+{
+  ReadBuffer<MergedGraph::lcp_type> lcp_array; lcp_array.open(graph.lcp_name);
+  std::vector<size_type> node_lcp, first_time, last_time;
+
+  size_type next = 0;
+  for(size_type i = 0; i < graph.size(); i++)
+  {
+    while(next < partitions.size() && partitions[next].start <= i)
+    {
+      partitions[next].node_lcp = node_lcp;
+      partitions[next].first_time = first_time;
+      partitions[next].last_time = last_time;
+      next++;
+    }
+    lcp_array.seek(i);
+    size_type curr_lcp = lcp_array[i] + (i > 0 ? 1 : 0); // Handle LCP[0] as -1.
+    while(!(node_lcp.empty()) && node_lcp.back() > curr_lcp)
+    {
+      node_lcp.pop_back(); first_time.pop_back(); last_time.pop_back();
+    }
+    if(!(node_lcp.empty()) && node_lcp.back() == curr_lcp) { last_time.back() = i; }
+    else { node_lcp.push_back(curr_lcp); first_time.push_back(i); last_time.push_back(i); }
+  }
+
+  lcp_array.close();
+}
+
+void
+CountPartition::count(const MergedGraph& graph, const NodeMapping& mapping,
+  const sdsl::sd_vector<>::rank_1_type& from_rank)
+{
+  MergedGraphReader reader;
+  {
+    MergedGraphSearcher searcher(graph);
+    reader.init(graph, this->start, searcher.findFrom(this->start), nullptr, nullptr);
+  }
+  ReadBuffer<MergedGraph::lcp_type> lcp_array; lcp_array.open(graph.lcp_name);
+  std::vector<size_type> node_lcp = this->node_lcp, first_time = this->first_time, last_time = this->last_time;
+  size_type depth = node_lcp.size();  // Nodes remaining from the initial stack.
+  bool updated = false;               // Has the top remaining node been updated?
+  std::unordered_map<size_type, size_type> prev_occ;
+
+  std::vector<node_type> curr_from;
+  for(size_type i = this->start; i < this->limit; i++, reader.advance())
+  {
+    reader.fromNodes(curr_from, mapping);
+    if(curr_from.size() > 1) { this->occurrences.push_back(range_type(i, curr_from.size() - 1)); }
+    lcp_array.seek(i);
+    size_type curr_lcp = lcp_array[i] + (i > 0 ? 1 : 0); // Handle LCP[0] as -1.
+    while(!(node_lcp.empty()) && node_lcp.back() > curr_lcp)
+    {
+      node_lcp.pop_back(); first_time.pop_back(); last_time.pop_back();
+    }
+    if(node_lcp.size() < depth) { depth = node_lcp.size(); updated = false; }
+    if(!(node_lcp.empty()) && node_lcp.back() == curr_lcp)
+    {
+      last_time.back() = i;
+      if(node_lcp.size() == depth) { updated = true; }
+    }
+    else { node_lcp.push_back(curr_lcp); first_time.push_back(i); last_time.push_back(i); }
+    for(size_type j = 0; j < curr_from.size(); j++)
+    {
+      size_type temp = from_rank(curr_from[j]);
+      auto iter = prev_occ.find(temp);
+      if(iter != prev_occ.end())
+      {
+        size_type pos = std::lower_bound(last_time.begin(), last_time.end(), iter->second) - last_time.begin();
+        this->redundant.push_back(first_time[pos] - 1);
+        iter->second = i + 1;
+      }
+      else
+      {
+        size_type next_time = (node_lcp.size() > depth ? first_time[depth] : 0);
+        this->first_occ.push_back({ temp, depth, next_time, updated });
+        prev_occ[temp] = i + 1;
+      }
+    }
+  }
+
+  this->last_occ.insert(this->last_occ.end(), prev_occ.begin(), prev_occ.end());
+  reader.close();
+  lcp_array.close();
+}
+
+void
+CountPartition::resolve(sdsl::int_vector<0>& prev_occ, CounterArray& occurrences, CounterArray& redundant)
+{
+  for(range_type occ : this->occurrences) { occurrences.increment(occ.first, occ.second); }
+  for(size_type pos : this->redundant) { redundant.increment(pos); }
+  for(const FirstOccurrence& occ : this->first_occ)
+  {
+    size_type prev = prev_occ[occ.rank];
+    if(prev == 0) { continue; }
+    size_type pos = std::lower_bound(this->last_time.begin(), this->last_time.begin() + occ.depth, prev) - this->last_time.begin();
+    if(pos < occ.depth) { redundant.increment(this->first_time[pos] - 1); }
+    else if(occ.updated) { redundant.increment(this->first_time[occ.depth - 1] - 1); }
+    else { redundant.increment(occ.next_time - 1); }
+  }
+  for(range_type occ : this->last_occ) { prev_occ[occ.first] = occ.second; }
 
-  if(graph.size() == 0) { return; }
+  sdsl::util::clear(this->node_lcp); sdsl::util::clear(this->first_time); sdsl::util::clear(this->last_time);
+  sdsl::util::clear(this->occurrences); sdsl::util::clear(this->redundant);
+  sdsl::util::clear(this->first_occ); sdsl::util::clear(this->last_occ);
+}
+
+//------------------------------------------------------------------------------
+
+// Each thread in the final construction step gets at least this many paths.
+const size_type PARALLEL_BUILD_SIZE = 65536;
+
+void
+checkInputSize(const InputGraph& graph, const ConstructionParameters& parameters)
+{
   size_type bytes_required = graph.size() * (sizeof(PathNode) + 2 * sizeof(PathNode::rank_type));
   if(bytes_required > parameters.getLimitBytes())
   {
@@ -454,33 +1097,47 @@ GCSA::GCSA(InputGraph& graph, const ConstructionParameters& parameters) :
     std::cerr << "GCSA::GCSA(): Construction aborted" << std::endl;
     std::exit(EXIT_FAILURE);
   }
+}
+
+GCSA::GCSA(InputGraph& graph, const ConstructionParameters& parameters) :
+  GCSA()
+{
+  double start = readTimer();
+
+  // The size of streaming input is only known after the initial PathGraph.
+  if(!(graph.streaming()))
+  {
+    if(graph.size() == 0) { return; }
+    checkInputSize(graph, parameters);
+  }
 
-  // Extract the keys and build the necessary support structures.
+  // Read the input, create the initial PathGraph, and extract the keys and the start nodes.
   // FIXME Later: Write the structures to disk until needed?
   std::vector<key_type> keys;
-  graph.readKeys(keys);
+  std::vector<node_type> from_node_buffer;
+  PathGraph path_graph(graph, keys, from_node_buffer, parameters.getCompressTemp());
+  if(graph.streaming())
+  {
+    if(graph.size() == 0) { return; }
+    checkInputSize(graph, parameters);
+  }
+
+  // Build the necessary support structures.
   DeBruijnGraph mapper(keys, graph.k(), graph.alpha);
   LCP lcp(keys, graph.k());
   sdsl::int_vector<0> last_char;
   Key::lastChars(keys, last_char);
-  sdsl::int_vector<0> distinct_labels(keys.size(), 0, bit_length(Key::label(keys.back())));
-  for(size_type i = 0; i < keys.size(); i++) { distinct_labels[i] = Key::label(keys[i]); }
   sdsl::util::clear(keys);
 
   // Determine the existing start nodes. Because the information is only used for index
   // construction, we use NodeMapping to map the node ids used for construction to the
   // node ids reported by locate().
-  std::vector<node_type> from_node_buffer;
-  graph.readFrom(from_node_buffer, true);
   sdsl::sd_vector<> from_nodes(from_node_buffer.begin(), from_node_buffer.end());
   sdsl::sd_vector<>::rank_1_type from_rank;
   sdsl::util::init_support(from_rank, &(from_nodes));
   size_type unique_from_nodes = from_node_buffer.size();
   sdsl::util::clear(from_node_buffer);
 
-  // Create the initial PathGraph.
-  PathGraph path_graph(graph, distinct_labels);
-  sdsl::util::clear(distinct_labels);
   if(Verbosity::level >= Verbosity::EXTENDED)
   {
     double stop = readTimer();
@@ -519,6 +1176,7 @@ GCSA::GCSA(InputGraph& graph, const ConstructionParameters& parameters) :
   }
   MergedGraph merged_graph(path_graph, mapper, lcp, parameters.getLimitBytes() - path_graph.bytes());
   this->header.path_nodes = merged_graph.size();
+  if(parameters.getMappable()) { this->header.set(GCSAHeader::MAPPABLE); }
   this->header.order = merged_graph.k();
   path_graph.clear();
   sdsl::util::clear(lcp);
@@ -535,129 +1193,177 @@ GCSA::GCSA(InputGraph& graph, const ConstructionParameters& parameters) :
   {
     std::cerr << "GCSA::GCSA(): Building the index" << std::endl;
   }
-  sdsl::int_vector<64> counts(graph.alpha.sigma, 0); // alpha
   std::vector<bit_vector> bwt(graph.alpha.sigma); // fast_bwt, sparse_bwt
   for(size_type comp = 0; comp < bwt.size(); comp++) { bwt[comp] = bit_vector(merged_graph.size(), 0); }
-  CounterArray outdegrees(merged_graph.size(), 4); // edges
   bit_vector sampled_positions(merged_graph.size(), 0); // sampled_paths
-  std::vector<node_type> sample_buffer; // stored_samples
-  this->samples = bit_vector(merged_graph.size() + merged_graph.extra(), 0);
 
   // Structures used for building counting support.
-  // Invariant: The previous occurrence of from node x was at path prev_occ[from_rank(x)] - 1.
   CounterArray occurrences(merged_graph.size(), 4), redundant(merged_graph.size() - 1, 4);
-  sdsl::int_vector<0> prev_occ(unique_from_nodes, 0, bit_length(merged_graph.size()));
-  std::vector<size_type> node_lcp, first_time, last_time;
 
-  // Read pointers to the MergedGraph files.
-  std::vector<MergedGraphReader> reader(graph.alpha.sigma + 1);
-  reader[0].init(merged_graph, &mapper, &last_char);
-  for(size_type comp = 0; comp < graph.alpha.sigma; comp++)
+  // Partition the paths for parallel construction.
+#ifdef VERIFY_CONSTRUCTION
+  // Use many small partitions to test the verification of the reader positions.
+  size_type partition_count = Range::bound(merged_graph.size() / 1024, 1, 64);
+#else
+  size_type threads = omp_get_max_threads();
+  size_type partition_count = Range::bound(merged_graph.size() / PARALLEL_BUILD_SIZE, 1, threads);
+#endif
+  std::vector<BuildPartition> partitions(partition_count);
+  for(size_type i = 0; i < partition_count; i++)
   {
-    reader[comp + 1].init(merged_graph, comp);
+    partitions[i].start = (i * (merged_graph.size() / partition_count)) & ~(size_type)63;
+    if(i > 0) { partitions[i - 1].limit = partitions[i].start; }
   }
-  ReadBuffer<uint8_t> lcp_array; lcp_array.open(merged_graph.lcp_name);
-
-  // The actual construction.
-  PathLabel first, last;
-  size_type total_edges = 0, sample_bits = 0;
-  std::vector<node_type> pred_from, curr_from;
-  for(size_type i = 0; i < merged_graph.size(); i++, reader[0].advance())
+  partitions.back().limit = merged_graph.size();
+  partitions.front().start_paths.assign(merged_graph.next.begin(), merged_graph.next.begin() + graph.alpha.sigma);
+  if(Verbosity::level >= Verbosity::EXTENDED)
   {
-    // Find the predecessors.
-    size_type indegree = 0, pred_comp = 0;
-    bool sample_this = false;
-    for(size_type comp = 0; comp < graph.alpha.sigma; comp++)
-    {
-      if(!(reader[0].paths[reader[0].path].hasPredecessor(comp))) { continue; }
+    std::cerr << "GCSA::GCSA(): " << partition_count << " partitions" << std::endl;
+  }
 
-      // Find the predecessor of paths[i] with comp and the path intersecting it.
-      reader[0].predecessor(comp, first, last);
-      if(!(reader[comp + 1].intersect(first, last, 0)))
-      {
-        reader[comp + 1].advance();
-      }
+  std::vector<CountPartition> count_partitions(partition_count);
+  for(size_type i = 0; i < partition_count; i++)
+  {
+    count_partitions[i].start = partitions[i].start; count_partitions[i].limit = partitions[i].limit;
+  }
+  CountPartition::seed(merged_graph, count_partitions);
 
-      // Add the edge.
-      bwt[comp][i] = 1; counts[comp]++;
-      indegree++; outdegrees.increment(reader[comp + 1].path); total_edges++;
-      pred_comp = comp; // For sampling.
+  // The actual construction. The first jobs build the counting support.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(size_type job = 0; job < 2 * partition_count; job++)
+  {
+    if(job < partition_count)
+    {
+      count_partitions[job].count(merged_graph, graph.mapping, from_rank);
     }
+    else
+    {
+      partitions[job - partition_count].build(merged_graph, mapper, last_char, graph.mapping,
+        parameters.getSamplePeriod(), bwt, sampled_positions);
+    }
+  }
+  {
+    sdsl::int_vector<0> prev_occ(unique_from_nodes, 0, bit_length(merged_graph.size()));
+    for(size_type i = 0; i < partition_count; i++) { count_partitions[i].resolve(prev_occ, occurrences, redundant); }
+    count_partitions.clear();
+  }
 
-    /*
-      Get the start nodes and update the occurrences/redundant arrays.
-
-      We traverse the ST in inorder using the LCP array. For each internal node, we
-      record the LCP value and the first and the last times (positions) we have
-      encountered that value within the subtree. If we have encountered the current
-      from node before, the LCA of the previous and current occurrences is the
-      highest ST node we have encountered after the previous occurrence. We then
-      increment the redundant array at the first encounter with that node.
-    */
-    reader[0].fromNodes(curr_from, graph.mapping);
-    occurrences.increment(i, curr_from.size() - 1);
-    lcp_array.seek(i);
-    size_type curr_lcp = lcp_array[i] + (i > 0 ? 1 : 0); // Handle LCP[0] as -1.
-    while(!(node_lcp.empty()) && node_lcp.back() > curr_lcp)
+  // Verify the reader positions and rebuild the partitions where they were wrong.
+  std::vector<size_type> reader_paths(merged_graph.next.begin(), merged_graph.next.begin() + graph.alpha.sigma);
+  size_type rebuilt = 0;
+  for(size_type i = 0; i < partition_count; i++)
+  {
+    if(!(partitions[i].consistent(reader_paths)))
     {
-      node_lcp.pop_back(); first_time.pop_back(); last_time.pop_back();
+      partitions[i].start_paths = reader_paths;
+      partitions[i].build(merged_graph, mapper, last_char, graph.mapping, parameters.getSamplePeriod(),
+        bwt, sampled_positions);
+      rebuilt++;
     }
-    if(!(node_lcp.empty()) && node_lcp.back() == curr_lcp) { last_time.back() = i; }
-    else { node_lcp.push_back(curr_lcp); first_time.push_back(i); last_time.push_back(i); }
-    for(size_type j = 0; j < curr_from.size(); j++)
+    for(size_type comp = 0; comp < graph.alpha.sigma; comp++)
     {
-      size_type temp = from_rank(curr_from[j]);
-      if(prev_occ[temp] > 0)
-      {
-        size_type pos = std::lower_bound(last_time.begin(), last_time.end(), prev_occ[temp]) - last_time.begin();
-        redundant.increment(first_time[pos] - 1);
-      }
-      prev_occ[temp] = i + 1;
+      if(partitions[i].counts[comp] > 0) { reader_paths[comp] = partitions[i].last_target[comp]; }
     }
-
-    /*
-      Simple cases for sampling the node:
-      - multiple predecessors
-      - at the beginning of the source node with no real predecessors
-      - if a from node is divisible by the sample period
-    */
-    if(indegree > 1) { sample_this = true; }
-    if(reader[0].paths[reader[0].path].hasPredecessor(Alphabet::SINK_COMP)) { sample_this = true; }
-    for(size_type k = 0; k < curr_from.size(); k++)
+  }
+  if(rebuilt > 0 && Verbosity::level >= Verbosity::EXTENDED)
+  {
+    std::cerr << "GCSA::GCSA(): Rebuilt " << rebuilt << " partition(s) sequentially" << std::endl;
+  }
+#ifdef VERIFY_CONSTRUCTION
+  // Sequential construction for comparison.
+  BuildPartition sequential;
+  sequential.start = 0; sequential.limit = merged_graph.size();
+  sequential.start_paths = partitions.front().start_paths;
+  {
+    std::vector<bit_vector> sequential_bwt(graph.alpha.sigma);
+    for(size_type comp = 0; comp < sequential_bwt.size(); comp++)
+    {
+      sequential_bwt[comp] = bit_vector(merged_graph.size(), 0);
+    }
+    bit_vector sequential_sampled(merged_graph.size(), 0);
+    sequential.build(merged_graph, mapper, last_char, graph.mapping, parameters.getSamplePeriod(),
+      sequential_bwt, sequential_sampled);
+    if(sequential_sampled != sampled_positions)
     {
-      if(curr_from[k] % parameters.getSamplePeriod() == 0) { sample_this = true; break; }
+      std::cerr << "GCSA::GCSA(): Sampled positions differ from sequential construction" << std::endl;
+      std::exit(EXIT_FAILURE);
     }
+  }
+#endif
+  sdsl::util::clear(last_char); sdsl::util::clear(from_nodes);
 
-    // Sample if the start nodes cannot be derived from the only predecessor.
-    if(!sample_this)
+  // Combine the partitions.
+  sdsl::int_vector<64> counts(graph.alpha.sigma, 0); // alpha
+  size_type total_edges = 0, total_samples = 0, sample_bits = 0;
+  for(size_type i = 0; i < partition_count; i++)
+  {
+    for(size_type comp = 0; comp < graph.alpha.sigma; comp++) { counts[comp] += partitions[i].counts[comp]; }
+    total_samples += partitions[i].samples.size();
+    sample_bits = std::max(sample_bits, partitions[i].sample_bits);
+  }
+  for(size_type comp = 0; comp < graph.alpha.sigma; comp++) { total_edges += counts[comp]; }
+  this->header.edges = total_edges;
+
+  // Edges to paths starting with comp precede the edges to paths starting with comp + 1.
+  bit_vector edge_buffer(total_edges, 0);
+  for(size_type comp = 0, offset = 0; comp < graph.alpha.sigma; comp++)
+  {
+    for(size_type i = 0; i < partition_count; i++)
     {
-      reader[pred_comp + 1].fromNodes(pred_from, graph.mapping);
-      if(pred_from.size() != curr_from.size()) { sample_this = true; }
-      else
+      BuildPartition& curr = partitions[i];
+      if(curr.counts[comp] == 0) { continue; }
+      for(size_type next = i + 1; next < partition_count; next++)
       {
-        for(size_type k = 0; k < curr_from.size(); k++)
+        if(partitions[next].counts[comp] == 0) { continue; }
+        if(partitions[next].first_target[comp] == curr.last_target[comp])
         {
-          if(curr_from[k] != pred_from[k] + 1) { sample_this = true; break; }
+          curr.edges[comp][curr.counts[comp] - 1] = 0;
         }
+        break;
+      }
+      for(size_type j = 0; j < curr.counts[comp]; j += 64)
+      {
+        size_type len = std::min((size_type)64, curr.counts[comp] - j);
+        edge_buffer.set_int(offset + j, curr.edges[comp].get_int(j, len), len);
       }
+      offset += curr.counts[comp];
+      sdsl::util::clear(curr.edges[comp]);
     }
+  }
 
-    // Store the samples.
-    if(sample_this)
+  std::vector<node_type> sample_buffer; sample_buffer.reserve(total_samples); // stored_samples
+  this->samples = bit_vector(total_samples, 0);
+  for(size_type i = 0; i < partition_count; i++)
+  {
+    for(size_type j = 0; j < partitions[i].sample_ends.size(); j++)
     {
-      sampled_positions[i] = 1;
-      for(size_type k = 0; k < curr_from.size(); k++)
-      {
-        sample_bits = std::max(sample_bits, bit_length(curr_from[k]));
-        sample_buffer.push_back(curr_from[k]);
-      }
-      this->samples[sample_buffer.size() - 1] = 1;
+      this->samples[sample_buffer.size() + partitions[i].sample_ends[j] - 1] = 1;
     }
+    sample_buffer.insert(sample_buffer.end(), partitions[i].samples.begin(), partitions[i].samples.end());
+    sdsl::util::clear(partitions[i].samples); sdsl::util::clear(partitions[i].sample_ends);
   }
-  for(size_type i = 0; i < reader.size(); i++) { reader[i].close(); }
-  lcp_array.close();
-  sdsl::util::clear(last_char); sdsl::util::clear(from_nodes); sdsl::util::clear(prev_occ);
-  this->header.edges = total_edges;
+  partitions.clear();
+
+#ifdef VERIFY_CONSTRUCTION
+  {
+    bit_vector sequential_edges(total_edges, 0), sequential_samples(total_samples, 0);
+    for(size_type comp = 0, offset = 0; comp < graph.alpha.sigma; comp++)
+    {
+      for(size_type i = 0; i < sequential.counts[comp]; i++) { sequential_edges[offset + i] = sequential.edges[comp][i]; }
+      offset += sequential.counts[comp];
+    }
+    for(size_type i = 0; i < sequential.sample_ends.size(); i++) { sequential_samples[sequential.sample_ends[i] - 1] = 1; }
+    if(sequential_edges != edge_buffer || sequential.samples != sample_buffer || sequential_samples != this->samples)
+    {
+      std::cerr << "GCSA::GCSA(): Edges or samples differ from sequential construction" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    if(Verbosity::level >= Verbosity::EXTENDED)
+    {
+      std::cerr << "GCSA::GCSA(): Parallel construction matches sequential construction" << std::endl;
+    }
+  }
+#endif
 
   // Initialize alpha.
   this->alpha = Alphabet(counts, graph.alpha.char2comp, graph.alpha.comp2char);
@@ -669,35 +1375,60 @@ GCSA::GCSA(InputGraph& graph, const ConstructionParameters& parameters) :
   this->redundant_pointers = SadaCount(redundant);
   sdsl::util::clear(occurrences); sdsl::util::clear(redundant);
 
-  // Initialize bwt.
-  this->fast_bwt.resize(this->alpha.sigma); this->fast_rank.resize(this->alpha.sigma);
+  // Initialize bwt. All fast_bwt entries must use the same layout, as it is determined
+  // by the header when loading.
+  bool rank_vectors = parameters.getRankVectors();
+  if(rank_vectors) { this->header.set(GCSAHeader::RANK_VECTORS); }
+  this->fast_bwt = std::vector<fast_vector>(this->alpha.sigma, fast_vector(bit_vector(), rank_vectors));
+  this->fast_rank.resize(this->alpha.sigma);
   this->sparse_bwt.resize(this->alpha.sigma); this->sparse_rank.resize(this->alpha.sigma);
-  this->sparse_bwt[0] = bwt[0]; sdsl::util::clear(bwt[0]);
-  for(size_type comp = 1; comp <= graph.alpha.fast_chars; comp++)
+  if(parameters.getPackedBWT())
   {
-    this->fast_bwt[comp] = bwt[comp]; sdsl::util::clear(bwt[comp]);
+    this->header.set(GCSAHeader::PACKED_BWT);
+    this->packed_bwt = PackedBWT(bwt, graph.alpha.fast_chars);
+    for(size_type comp = 1; comp <= graph.alpha.fast_chars; comp++) { sdsl::util::clear(bwt[comp]); }
   }
-  for(size_type comp = graph.alpha.fast_chars + 1; comp < graph.alpha.sigma; comp++)
+  else if(parameters.getRunLengthBWT())
   {
-    this->sparse_bwt[comp] = bwt[comp]; sdsl::util::clear(bwt[comp]);
+    this->header.set(GCSAHeader::RUN_LENGTH_BWT);
+    this->run_length_bwt.resize(graph.alpha.fast_chars + 1);
+    for(size_type comp = 1; comp <= graph.alpha.fast_chars; comp++)
+    {
+      this->run_length_bwt[comp] = RunLengthVector(bwt[comp]); sdsl::util::clear(bwt[comp]);
+    }
   }
-
-  // Initialize bitvectors (edges, sampled_positions, samples).
-  bit_vector edge_buffer(total_edges, 0); total_edges = 0;
-  for(size_type i = 0; i < merged_graph.size(); i++)
+  else
+  {
+    for(size_type comp = 1; comp <= graph.alpha.fast_chars; comp++)
+    {
+      this->fast_bwt[comp] = fast_vector(bwt[comp], rank_vectors); sdsl::util::clear(bwt[comp]);
+    }
+  }
+  if(parameters.getCombinedSparse())
   {
-    total_edges += outdegrees[i];
-    edge_buffer[total_edges - 1] = 1;
+    this->header.set(GCSAHeader::COMBINED_SPARSE);
+    this->sparse_combined = SparseBWT(bwt, graph.alpha.fast_chars);
+    sdsl::util::clear(bwt[0]);
+    for(size_type comp = graph.alpha.fast_chars + 1; comp < graph.alpha.sigma; comp++) { sdsl::util::clear(bwt[comp]); }
   }
-  outdegrees.clear();
-  this->edges = edge_buffer; sdsl::util::clear(edge_buffer);
-  this->sampled_paths = sampled_positions; sdsl::util::clear(sampled_positions);
-  this->samples.resize(sample_buffer.size());
+  else
+  {
+    this->sparse_bwt[0] = bwt[0]; sdsl::util::clear(bwt[0]);
+    for(size_type comp = graph.alpha.fast_chars + 1; comp < graph.alpha.sigma; comp++)
+    {
+      this->sparse_bwt[comp] = bwt[comp]; sdsl::util::clear(bwt[comp]);
+    }
+  }
+
+  // Initialize bitvectors (edges, sampled_positions, samples).
+  this->edges = fast_vector(edge_buffer, rank_vectors); sdsl::util::clear(edge_buffer);
+  this->sampled_paths = fast_vector(sampled_positions, rank_vectors); sdsl::util::clear(sampled_positions);
   this->initSupport();
 
   // Initialize stored_samples.
   this->stored_samples = sdsl::int_vector<0>(sample_buffer.size(), 0, sample_bits);
   for(size_type i = 0; i < sample_buffer.size(); i++) { this->stored_samples[i] = sample_buffer[i]; }
+  this->sample_values = IntVectorView(this->stored_samples);
   sdsl::util::clear(sample_buffer);
 
   // Transfer the LCP array from MergedGraph to InputGraph.
@@ -736,12 +1467,92 @@ GCSA::initSupport()
 
 //------------------------------------------------------------------------------
 
+const size_type FIND_BATCH_SIZE = 32; // Number of concurrent searches in batched find().
+
+void
+GCSA::find(const std::vector<std::string>& patterns, std::vector<range_type>& results) const
+{
+  results.resize(patterns.size());
+  if(this->size() == 0)
+  {
+    for(size_type i = 0; i < patterns.size(); i++) { results[i] = range_type(0, this->size() - 1); }
+    return;
+  }
+
+  /*
+    Each active search is a pair (pattern, remaining characters). When a search
+    finishes, the next pattern takes its place. Within a round, the LF() steps
+    of different searches are independent of each other. Each round makes three
+    passes over the active searches: prefetch the BWT blocks, compute the outgoing
+    ranges and prefetch the edge blocks, and finally compute the path node ranges.
+  */
+  std::vector<range_type> active; active.reserve(FIND_BATCH_SIZE);
+  size_type next = 0;
+  while(next < patterns.size() || !(active.empty()))
+  {
+    while(active.size() < FIND_BATCH_SIZE && next < patterns.size())
+    {
+      const std::string& pattern = patterns[next];
+      if(pattern.empty()) { results[next] = range_type(0, this->size() - 1); }
+      else
+      {
+        results[next] = this->charRange(this->alpha.char2comp[pattern.back()]);
+        if(pattern.length() > 1 && !Range::empty(results[next]))
+        {
+          active.push_back(range_type(next, pattern.length() - 1));
+        }
+      }
+      next++;
+    }
+
+    for(size_type i = 0; i < active.size(); i++)
+    {
+      range_type search = active[i];
+      this->prefetchOutgoing(results[search.first], this->alpha.char2comp[patterns[search.first][search.second - 1]]);
+    }
+    for(size_type i = 0; i < active.size(); i++)
+    {
+      range_type search = active[i];
+      range_type& range = results[search.first];
+      range = this->outgoingRange(range, this->alpha.char2comp[patterns[search.first][search.second - 1]]);
+      if(!Range::empty(range)) { this->prefetchPathNodes(range); }
+    }
+    size_type tail = 0;
+    for(size_type i = 0; i < active.size(); i++)
+    {
+      range_type search = active[i]; search.second--;
+      range_type& range = results[search.first];
+      if(Range::empty(range)) { continue; }
+      range = this->pathNodeRange(range);
+      if(search.second > 0) { active[tail] = search; tail++; }
+    }
+    active.resize(tail);
+  }
+}
+
+//------------------------------------------------------------------------------
+
 void
 GCSA::LF_fast(range_type range, std::vector<range_type>& results) const
 {
   for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++) { results[comp] = Range::empty_range(); }
   if(Range::empty(range)) { return; }
 
+  if(this->packed())
+  {
+    this->LF_packed(range, results);
+    return;
+  }
+
+  if(this->runLength())
+  {
+    for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
+    {
+      results[comp] = this->LF(range, comp);
+    }
+    return;
+  }
+
   if(range.first == range.second) // Single path node.
   {
     for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
@@ -768,7 +1579,12 @@ GCSA::LF_all(range_type range, std::vector<range_type>& results) const
   for(size_type comp = 1; comp + 1 < this->alpha.sigma; comp++) { results[comp] = Range::empty_range(); }
   if(Range::empty(range)) { return; }
 
-  if(range.first == range.second) // Single path node.
+  // Fast characters.
+  if(this->packed())
+  {
+    this->LF_packed(range, results);
+  }
+  else if(range.first == range.second && !(this->runLength())) // Single path node.
   {
     for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
     {
@@ -777,6 +1593,22 @@ GCSA::LF_all(range_type range, std::vector<range_type>& results) const
         results[comp].first = results[comp].second = this->edge_rank(this->LF(this->fast_rank, range.first, comp));
       }
     }
+  }
+  else
+  {
+    for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
+    {
+      results[comp] = this->LF(range, comp);
+    }
+  }
+
+  // Sparse characters.
+  if(this->combinedSparse())
+  {
+    this->LF_sparse(range, results);
+  }
+  else if(range.first == range.second) // Single path node.
+  {
     for(size_type comp = this->alpha.fast_chars + 1; comp + 1 < this->alpha.sigma; comp++)
     {
       if(this->sparse_bwt[comp][range.first])
@@ -785,15 +1617,48 @@ GCSA::LF_all(range_type range, std::vector<range_type>& results) const
       }
     }
   }
-  else  // General case.
+  else
   {
-    for(size_type comp = 1; comp + 1 < this->alpha.sigma; comp++)
+    for(size_type comp = this->alpha.fast_chars + 1; comp + 1 < this->alpha.sigma; comp++)
     {
       results[comp] = this->LF(range, comp);
     }
   }
 }
 
+void
+GCSA::LF_packed(range_type range, std::vector<range_type>& results) const
+{
+  size_type first[PackedBWT::CHARS + 1], last[PackedBWT::CHARS + 1];
+  this->packed_bwt.rank(range.first, first);
+  this->packed_bwt.rank(range.second + 1, last);
+  for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
+  {
+    if(last[comp] > first[comp])
+    {
+      results[comp].first = this->alpha.C[comp] + first[comp];
+      results[comp].second = this->alpha.C[comp] + last[comp] - 1;
+      results[comp] = this->pathNodeRange(results[comp]);
+    }
+  }
+}
+
+void
+GCSA::LF_sparse(range_type range, std::vector<range_type>& results) const
+{
+  size_type first[Alphabet::MAX_SIGMA], last[Alphabet::MAX_SIGMA];
+  this->sparse_combined.rank(range.first, first);
+  this->sparse_combined.rank(range.second + 1, last);
+  for(size_type j = 1; j + 1 < this->sparse_combined.charCount(); j++)
+  {
+    if(last[j] <= first[j]) { continue; }
+    comp_type comp = this->sparse_combined.charComp(j);
+    results[comp].first = this->alpha.C[comp] + first[j];
+    results[comp].second = this->alpha.C[comp] + last[j] - 1;
+    results[comp] = this->pathNodeRange(results[comp]);
+  }
+}
+
 //------------------------------------------------------------------------------
 
 size_type
@@ -807,6 +1672,16 @@ GCSA::count(range_type range) const
 
 //------------------------------------------------------------------------------
 
+// Ranges of at least this many paths are located using multiple threads.
+const size_type PARALLEL_LOCATE_SIZE = 4096;
+
+// Number of blocks per thread in parallel locate().
+const size_type PARALLEL_LOCATE_BLOCKS = 4;
+
+// Number of concurrent walks / paths per output chunk in batched locate.
+const size_type LOCATE_BATCH_SIZE = 32;
+const size_type LOCATE_CHUNK_SIZE = 1024;
+
 void
 GCSA::locate(size_type path_node, std::vector<node_type>& results, bool append, bool sort) const
 {
@@ -831,10 +1706,14 @@ GCSA::locate(range_type range, std::vector<node_type>& results, bool append, boo
     return;
   }
 
-  for(size_type i = range.first; i <= range.second; i++)
+  size_type threads = omp_get_max_threads();
+  if(threads > 1 && !omp_in_parallel() && Range::length(range) >= PARALLEL_LOCATE_SIZE)
   {
-    this->locateInternal(i, results);
+    this->locateParallel(range, results, threads, sort);
+    return;
   }
+
+  this->locateBatch(range.first, range.second + 1, results);
   if(sort) { removeDuplicates(results, false); }
 }
 
@@ -874,6 +1753,39 @@ GCSA::locate(range_type range, size_type max_positions, std::vector<node_type>&
   sequentialSort(results.begin(), results.end());
 }
 
+void
+GCSA::locateParallel(range_type range, std::vector<node_type>& results, size_type threads, bool sort) const
+{
+  // Each block gets its own buffer, which is sorted before merging to reduce the volume.
+  size_type blocks = std::min(threads * PARALLEL_LOCATE_BLOCKS, Range::length(range));
+  std::vector<std::vector<node_type>> buffers(blocks);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(size_type block = 0; block < blocks; block++)
+  {
+    size_type first = range.first + (block * Range::length(range)) / blocks;
+    size_type last = range.first + ((block + 1) * Range::length(range)) / blocks;
+    std::vector<node_type>& buffer = buffers[block];
+    this->locateBatch(first, last, buffer);
+    if(sort) { removeDuplicates(buffer, false); }
+  }
+
+  size_type offset = results.size(), total = 0;
+  std::vector<size_type> offsets(blocks);
+  for(size_type block = 0; block < blocks; block++)
+  {
+    offsets[block] = offset + total; total += buffers[block].size();
+  }
+  results.resize(offset + total);
+  #pragma omp parallel for schedule(static)
+  for(size_type block = 0; block < blocks; block++)
+  {
+    std::copy(buffers[block].begin(), buffers[block].end(), results.begin() + offsets[block]);
+    sdsl::util::clear(buffers[block]);
+  }
+
+  if(sort) { removeDuplicates(results, true); }
+}
+
 void
 GCSA::locateInternal(size_type path_node, std::vector<node_type>& results) const
 {
@@ -883,13 +1795,45 @@ GCSA::locateInternal(size_type path_node, std::vector<node_type>& results) const
     path_node = this->LF(path_node);
     steps++;
   }
+  this->addSamples(path_node, steps, results);
+}
 
-  size_type sample = this->firstSample(path_node);
-  do
+void
+GCSA::locateBatch(size_type first, size_type last, std::vector<node_type>& results) const
+{
+  /*
+    Each LF() step depends on the previous one, so a single walk is bound by memory
+    latency. We keep LOCATE_BATCH_SIZE walks active at once and advance them in rounds.
+    A finished walk is replaced by the next path in the chunk. The results are reported
+    in path order after the chunk has been processed.
+  */
+  std::vector<range_type> walks(LOCATE_CHUNK_SIZE); // (path node, steps)
+  std::vector<size_type> active; active.reserve(LOCATE_BATCH_SIZE);
+  for(size_type chunk = first; chunk < last; chunk += LOCATE_CHUNK_SIZE)
   {
-    results.push_back(this->sample(sample) + steps); sample++;
+    size_type chunk_size = std::min(LOCATE_CHUNK_SIZE, last - chunk), next = 0;
+    while(next < chunk_size || !(active.empty()))
+    {
+      while(active.size() < LOCATE_BATCH_SIZE && next < chunk_size)
+      {
+        walks[next] = range_type(chunk + next, 0);
+        active.push_back(next); next++;
+      }
+
+      size_type tail = 0;
+      for(size_type i = 0; i < active.size(); i++)
+      {
+        range_type& walk = walks[active[i]];
+        if(this->sampled(walk.first)) { continue; }
+        walk.first = this->LF(walk.first); walk.second++;
+        if(this->packed()) { this->packed_bwt.prefetch(walk.first); }
+        active[tail] = active[i]; tail++;
+      }
+      active.resize(tail);
+    }
+
+    for(size_type i = 0; i < chunk_size; i++) { this->addSamples(walks[i].first, walks[i].second, results); }
   }
-  while(!(this->lastSample(sample - 1)));
 }
 
 //------------------------------------------------------------------------------
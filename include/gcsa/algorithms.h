@@ -27,6 +27,7 @@
 #define GCSA_ALGORITHMS_H
 
 #include <gcsa/gcsa.h>
+#include <gcsa/kmer_table.h>
 #include <gcsa/lcp.h>
 
 namespace gcsa
@@ -91,6 +92,141 @@ std::array<size_type, 3> compareKMers(const GCSA& left, const GCSA& right, size_
 
 //------------------------------------------------------------------------------
 
+struct ApproximateSearchParameters
+{
+  enum distance_type { HAMMING, EDIT };
+
+  distance_type distance;    // Allow mismatches or mismatches and indels.
+  size_type     seed_length; // Parallelize using the subtrees after this many steps.
+  bool          include_Ns;  // Allow substituting and inserting Ns.
+
+  constexpr static size_type SEED_LENGTH = 5;
+
+  ApproximateSearchParameters() : distance(HAMMING), seed_length(SEED_LENGTH), include_Ns(false) {}
+};
+
+/*
+  Approximate search. Finds the ranges of all patterns within Hamming or edit distance k
+  of the given pattern using backtracking backward search. The results are pairs (range,
+  errors) sorted by range, with each range reported once with the smallest number of
+  errors. As with find(), the results may have false positives if the pattern is longer
+  than the order of the index.
+
+  The search is pruned with a lower bound for the number of errors in each prefix of the
+  pattern, based on partitioning the prefix into substrings that do not occur in the
+  index. The subtrees after seed_length steps are processed in parallel.
+
+  By default, the search substitutes only the bases (comp values in fast_bwt). Insertions
+  and deletions are not allowed at the ends of the pattern, as they would only report
+  supersets and subsets of the ranges of other alignments.
+*/
+void approximateSearch(const GCSA& index, const std::string& pattern, size_type k,
+  std::vector<std::pair<range_type, size_type>>& results,
+  const ApproximateSearchParameters& parameters = ApproximateSearchParameters());
+
+//------------------------------------------------------------------------------
+
+/*
+  Bidirectional search for indexes of graphs that contain both strands of the sequences.
+  The search keeps the ranges of the current pattern P and its reverse complement rc(P).
+  extendLeft(c) takes a single LF() step from the range of P, and extendRight(c) takes a
+  single LF() step from the range of rc(P) using the complement of c.
+
+  Unlike in the FMD-index, the ranges cannot be updated in sync. The FMD-index derives
+  the range of rc(cP) from the range of rc(P) by counting the occurrences of the
+  smaller characters in the range of P, which requires that the suffixes of P and rc(P)
+  are in the same sorted order with one entry per occurrence. In GCSA, the path nodes
+  are prefix-pruned independently on each strand, so the sizes of the ranges of P and
+  rc(P) differ, and there is no mapping from one range to the other. Appending a
+  character to rc(P) would also require a forward step, which the index does not
+  support.
+
+  Hence the state keeps each range only while it is up to date. Extending the pattern
+  in the same direction costs one LF() step per character. After a change of
+  direction, the first call to range() or rcRange() for the other strand costs O(|P|)
+  LF() steps, because the range is recomputed from the pattern. Callers that alternate
+  between the directions should batch the extensions in each direction. forwardValid()
+  and reverseValid() tell whether the next call to range() or rcRange() is free.
+
+  An extension that would result in an empty range fails and leaves the search state
+  unchanged. As with find(), patterns longer than the order of the index may have false
+  positives.
+*/
+
+class BidirectionalSearch
+{
+public:
+  typedef gcsa::size_type size_type;
+
+  explicit BidirectionalSearch(const GCSA& gcsa);
+
+  // Resets the pattern to the empty string.
+  void clear();
+
+  bool extendLeft(char_type c);
+  bool extendRight(char_type c);
+
+  inline const std::string& pattern() const { return this->text; }
+  inline size_type length() const { return this->text.length(); }
+
+  // Range of the pattern / the reverse complement in the index. O(length()) LF() steps
+  // if the range is not valid, and constant time otherwise.
+  range_type range();
+  range_type rcRange();
+
+  inline bool forwardValid() const { return this->forward_valid; }
+  inline bool reverseValid() const { return this->reverse_valid; }
+
+  // Complements A, C, G, and T in either case. Other characters are their own complements.
+  static char_type complement(char_type c);
+
+private:
+  const GCSA& index;
+  std::string text;
+  range_type  forward, reverse;
+  bool        forward_valid, reverse_valid;
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  Maximal exact matches. For each position of the read, backward search finds the longest
+  match starting there. A match read[begin, end) is reported if it cannot be extended to
+  the left and its length is at least min_length. Such matches are not contained in other
+  matches, so they are the super-maximal exact matches (SMEMs) of the read.
+
+  The search processes the read from right to left. When the range becomes empty, it
+  continues from LCPArray::parent() of the last non-empty range instead of restarting
+  find(). As with find(), matches longer than the order of the index may have false
+  positives. Characters mapping to comp value 0 never match.
+
+  The matches are reported in increasing order by begin. The batch version processes
+  the reads in parallel.
+*/
+
+struct MEM
+{
+  size_type  begin, end;
+  range_type range;
+
+  MEM() : begin(0), end(0), range(1, 0) {}
+  MEM(size_type b, size_type e, range_type r) : begin(b), end(e), range(r) {}
+
+  inline size_type length() const { return this->end - this->begin; }
+
+  inline bool operator== (const MEM& another) const
+  {
+    return (this->begin == another.begin && this->end == another.end && this->range == another.range);
+  }
+};
+
+void findMEMs(const GCSA& index, const LCPArray& lcp, const std::string& read, size_type min_length,
+  std::vector<MEM>& results);
+void findMEMs(const GCSA& index, const LCPArray& lcp, const std::vector<std::string>& reads, size_type min_length,
+  std::vector<std::vector<MEM>>& results);
+
+//------------------------------------------------------------------------------
+
 void printStatistics(const GCSA& gcsa, const LCPArray& lcp_array);
 
 //------------------------------------------------------------------------------
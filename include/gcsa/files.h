@@ -26,6 +26,8 @@
 #ifndef GCSA_FILES_H
 #define GCSA_FILES_H
 
+#include <functional>
+
 #include <gcsa/support.h>
 
 namespace gcsa
@@ -64,13 +66,32 @@ void writeKMers(const std::string& base_name, std::vector<KMer>& kmers, size_typ
 
 //------------------------------------------------------------------------------
 
+/*
+  A kmer producer for streaming input. Each call appends the next batch of kmers to
+  the vector and sets the kmer length. Returns false when there are no more kmers.
+*/
+typedef std::function<bool(std::vector<KMer>& kmers, size_type& kmer_length)> KMerProducer;
+
+// Reads the kmers from a stream that need not be seekable, such as a pipe.
+KMerProducer streamProducer(const std::string& filename, bool binary_format, const Alphabet& alphabet = Alphabet());
+
+//------------------------------------------------------------------------------
+
 /*
   An input graph is just a set of input files.
+
+  A streaming input graph reads the kmers from producers instead. Kmer counts and kmer
+  length are not known until the kmers have been consumed, and each producer can be
+  consumed only once.
 */
 
 struct InputGraph
 {
+  // The LCP array from GCSA construction is passed in a file of lcp_type values.
+  typedef std::uint16_t lcp_type;
+
   std::vector<std::string> filenames;
+  std::vector<KMerProducer> producers;  // Streaming input.
   std::string              lcp_name; // Used to pass the LCP array from GCSA construction.
   std::vector<size_type>   sizes;
 
@@ -86,6 +107,9 @@ struct InputGraph
 
   InputGraph(const std::vector<std::string>& files, bool binary_format, const Alphabet& alphabet = Alphabet(), const std::string& mapping_name = "");
   InputGraph(size_type file_count, char** base_names, bool binary_format, const Alphabet& alphabet = Alphabet(), const std::string& mapping_name = "");
+
+  // Streaming input. The names are only used in messages.
+  InputGraph(const std::vector<KMerProducer>& kmer_producers, const std::vector<std::string>& names, const Alphabet& alphabet = Alphabet(), const std::string& mapping_name = "");
   ~InputGraph();
 
   void open(std::ifstream& input, size_type file) const;
@@ -95,6 +119,7 @@ struct InputGraph
   inline size_type size() const { return this->kmer_count; }
   inline size_type k() const { return this->kmer_length; }
   inline size_type files() const { return this->filenames.size(); }
+  inline bool streaming() const { return !(this->producers.empty()); }
 
   /*
     Setting append = true has unpredictable side effects if done outside the member
@@ -103,6 +128,12 @@ struct InputGraph
   void read(std::vector<KMer>& kmers) const;
   void read(std::vector<KMer>& kmers, size_type file, bool append = false) const;
 
+  /*
+    Reads the kmers of the file without appending. With streaming input, this is the only
+    way to read the kmers, and it updates the kmer counts and the kmer length.
+  */
+  void consume(std::vector<KMer>& kmers, size_type file);
+
   // Get the keys for distinct labels with merged predecessors / successors in sorted order.
   void readKeys(std::vector<key_type>& keys) const;
 
@@ -121,8 +152,29 @@ private:
 /*
   GCSA file header.
 
+  Version 5 (GCSA v1.3):
+  - Flag RANK_VECTORS: fast_bwt, edges, and sampled_paths are stored as RankBitVector,
+    and their rank supports as empty structures. Without the flag, they are stored as
+    bit_vector_il as in version 3.
+  - The blocks of RankBitVector, PackedBWT, and SparseBWT are stored as aligned words
+    (see serializeWords()), so that they can be used from a memory-mapped file. The
+    words start at page boundaries with flag MAPPABLE and at cache line boundaries
+    otherwise. The padding is relative to the beginning of the file.
+  - Version 3 files without flags have the same body and can still be loaded. Other
+    earlier files must be rebuilt.
+
+  Version 4 (GCSA v1.3):
+  - fast_bwt, edges, and sampled_paths are stored as RankBitVector. The rank supports
+    are stored as empty structures.
+
   Version 3 (GCSA v0.8):
   - Changed to a faster CSA-style encoding.
+  - Flag PACKED_BWT: the fast characters are stored in a PackedBWT after fast_rank.
+  - Flag RUN_LENGTH_BWT: the fast characters are stored in RunLengthVectors for comp
+    values 1 to fast_chars after fast_rank.
+  - Flag COMBINED_SPARSE: the sparse characters are stored in a SparseBWT after sparse_rank.
+  - Flag MAPPABLE: stored_samples is stored as size, width, and page-aligned words
+    (see serializeWords()), so that it can be used from a memory-mapped file.
 
   Version 2 (GCSA v0.6):
   - Added OccurrenceCounter to the end of the body.
@@ -144,15 +196,28 @@ struct GCSAHeader
   constexpr static uint32_t TAG = 0x6C5A6C5A;
   constexpr static uint32_t VERSION = Version::GCSA_VERSION;
   constexpr static uint32_t MIN_VERSION = 1;
+  constexpr static uint32_t COMPATIBLE_VERSION = 3; // Without flags.
+
+  constexpr static uint64_t PACKED_BWT      = 0x0001;
+  constexpr static uint64_t MAPPABLE        = 0x0002;
+  constexpr static uint64_t RUN_LENGTH_BWT  = 0x0004;
+  constexpr static uint64_t COMBINED_SPARSE = 0x0008;
+  constexpr static uint64_t RANK_VECTORS    = 0x0010;
+  constexpr static uint64_t FLAG_MASK       = 0x001F;
 
   GCSAHeader();
 
   size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const;
   void load(std::istream& in);
-  bool check(uint32_t expected_version = VERSION) const;
+  bool check() const; // VERSION or COMPATIBLE_VERSION without flags.
+  bool check(uint32_t expected_version) const;
   bool checkNew() const;
 
   void swap(GCSAHeader& another);
+
+  void set(uint64_t flag) { this->flags |= flag; }
+  void unset(uint64_t flag) { this->flags &= ~flag; }
+  bool get(uint64_t flag) const { return (this->flags & flag); }
 };
 
 std::ostream& operator<<(std::ostream& stream, const GCSAHeader& header);
@@ -162,9 +227,17 @@ std::ostream& operator<<(std::ostream& stream, const GCSAHeader& header);
 /*
   LCP file header.
 
+  Version 2 (GCSA v1.3):
+  - The levels of the range minimum tree after the leaves start at multiples of 64
+    entries. The padding between the levels contains the maximal value.
+  - The values are stored using 8 bits, or 16 bits if they do not fit in a byte.
+
   Version 1 (GCSA v0.8)
   - The first use of the header.
   - LCP body is identical to version 0.
+  - Flag MAPPABLE: data is stored as size, width, and page-aligned words (see
+    serializeWords()), so that it can be used from a memory-mapped file.
+  - Still supported. LCPArray::load() converts the body to the version 2 layout.
 */
 
 struct LCPHeader
@@ -179,14 +252,22 @@ struct LCPHeader
   constexpr static uint32_t VERSION = Version::LCP_VERSION;
   constexpr static uint32_t MIN_VERSION = 1;
 
+  constexpr static uint64_t MAPPABLE  = 0x0001;
+  constexpr static uint64_t FLAG_MASK = 0x0001;
+
   LCPHeader();
 
   size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const;
   void load(std::istream& in);
-  bool check(uint32_t expected_version = VERSION) const;
+  bool check() const; // Any version from MIN_VERSION to VERSION.
+  bool check(uint32_t expected_version) const;
   bool checkNew() const;
 
   void swap(LCPHeader& another);
+
+  void set(uint64_t flag) { this->flags |= flag; }
+  void unset(uint64_t flag) { this->flags &= ~flag; }
+  bool get(uint64_t flag) const { return (this->flags & flag); }
 };
 
 std::ostream& operator<<(std::ostream& stream, const LCPHeader& header);
@@ -43,7 +43,7 @@ public:
   typedef gcsa::size_type       size_type;
 
   typedef sdsl::bit_vector      bit_vector;
-  typedef sdsl::bit_vector_il<> fast_vector;
+  typedef FastBitVector         fast_vector;
   typedef sdsl::sd_vector<>     sparse_vector;
 
 //------------------------------------------------------------------------------
@@ -60,6 +60,19 @@ public:
   size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const;
   void load(std::istream& in);
 
+  /*
+    Memory-maps the index file and serves queries directly from the mapping where the
+    layout allows it: packed_bwt, the blocks of sparse_combined, fast_bwt, edges, and
+    sampled_paths if rankVectors(), and stored_samples if the index was built with the
+    MAPPABLE flag.
+    The blocks start at page boundaries with MAPPABLE and at cache line boundaries
+    otherwise. The SDSL structures (sparse_bwt, run_length_bwt, the filter of
+    sparse_combined, samples, and the counting support) cannot use external memory, so
+    they are loaded normally. Returns false if the file cannot be mapped.
+  */
+  bool map(const std::string& filename);
+  inline bool mapped() const { return (this->mapping != nullptr); }
+
   const static std::string EXTENSION; // .gcsa
 
 //------------------------------------------------------------------------------
@@ -85,6 +98,8 @@ public:
     locate() stores the node identifiers in the given vector.
     If append is true, the results are appended to the existing vector.
     If sort is true, the results are sorted and the duplicates are removed.
+    Large ranges are located using multiple threads, unless locate() is called
+    from within a parallel region.
 
     The implementation of find() is based on bidirectional iterators.
 
@@ -121,6 +136,14 @@ public:
     return this->find(pattern, pattern + length);
   }
 
+  /*
+    Batched find(): results[i] = find(patterns[i]). The backward searches of several
+    patterns are interleaved, so that the cache misses of independent LF() steps can
+    overlap. This is faster than calling find() for each pattern separately when the
+    index is much larger than the cache.
+  */
+  void find(const std::vector<std::string>& patterns, std::vector<range_type>& results) const;
+
   size_type count(range_type range) const;
 
   void locate(size_type path, std::vector<node_type>& results, bool append = false, bool sort = true) const;
@@ -139,8 +162,8 @@ public:
   inline size_type edgeCount() const { return this->header.edges; }
   inline size_type order() const { return this->header.order; }
 
-  inline size_type sampleCount() const { return this->stored_samples.size(); }
-  inline size_type sampleBits() const { return this->stored_samples.width(); }
+  inline size_type sampleCount() const { return this->sample_values.size(); }
+  inline size_type sampleBits() const { return this->sample_values.width(); }
   inline size_type sampledPositions() const
   {
     if(this->empty()) { return 0; }
@@ -152,11 +175,21 @@ public:
     return this->pathNodeRange(gcsa::charRange(this->alpha, comp));
   }
 
+  // Are the fast characters stored in packed_bwt instead of fast_bwt?
+  inline bool packed() const { return this->header.get(GCSAHeader::PACKED_BWT); }
+
+  // Are the fast characters stored in run_length_bwt instead of fast_bwt?
+  inline bool runLength() const { return this->header.get(GCSAHeader::RUN_LENGTH_BWT); }
+
+  // Are the sparse characters stored in sparse_combined instead of sparse_bwt?
+  inline bool combinedSparse() const { return this->header.get(GCSAHeader::COMBINED_SPARSE); }
+
+  // Are fast_bwt, edges, and sampled_paths stored as RankBitVector instead of bit_vector_il?
+  inline bool rankVectors() const { return this->header.get(GCSAHeader::RANK_VECTORS); }
+
   inline range_type LF(range_type range, comp_type comp) const
   {
-    if(comp > 0 && comp <= this->alpha.fast_chars) { range = this->LF(this->fast_rank, range, comp); }
-    else { range = this->LF(this->sparse_rank, range, comp); }
-
+    range = this->outgoingRange(range, comp);
     if(Range::empty(range)) { return range; }
     return this->pathNodeRange(range);
   }
@@ -164,13 +197,41 @@ public:
   // Follow the first edge backwards. Try the fast characters first.
   inline size_type LF(size_type path_node) const
   {
-    for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
+    if(this->packed())
+    {
+      size_type chars = this->packed_bwt.chars(path_node);
+      if(chars != 0)
+      {
+        comp_type comp = sdsl::bits::lo(chars) + 1;
+        return this->edge_rank(this->LF(this->packed_bwt, path_node, comp));
+      }
+    }
+    else if(this->runLength())
+    {
+      for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
+      {
+        if(this->run_length_bwt[comp][path_node])
+        {
+          return this->edge_rank(this->LF(this->run_length_bwt, path_node, comp));
+        }
+      }
+    }
+    else
     {
-      if(this->fast_bwt[comp][path_node])
+      for(size_type comp = 1; comp <= this->alpha.fast_chars; comp++)
       {
-        return this->edge_rank(this->LF(this->fast_rank, path_node, comp));
+        if(this->fast_bwt[comp][path_node])
+        {
+          return this->edge_rank(this->LF(this->fast_rank, path_node, comp));
+        }
       }
     }
+    if(this->combinedSparse())
+    {
+      size_type rank = 0;
+      comp_type comp = this->sparse_combined.first(path_node, rank);
+      return this->edge_rank(this->alpha.C[comp] + rank);
+    }
     for(size_type comp = this->alpha.fast_chars + 1; comp < this->alpha.sigma; comp++)
     {
       if(this->sparse_bwt[comp][path_node])
@@ -207,7 +268,7 @@ public:
 
   inline bool lastSample(size_type i) const { return this->samples[i]; }
 
-  inline node_type sample(size_type i) const { return this->stored_samples[i]; }
+  inline node_type sample(size_type i) const { return this->sample_values[i]; }
 
 //------------------------------------------------------------------------------
 
@@ -218,10 +279,19 @@ public:
   std::vector<fast_vector>                fast_bwt;
   std::vector<fast_vector::rank_1_type>   fast_rank;
 
+  // Alternative encoding for the fast characters. Used instead of fast_bwt if packed().
+  PackedBWT                               packed_bwt;
+
+  // Alternative encoding for the fast characters. Used instead of fast_bwt if runLength().
+  std::vector<RunLengthVector>            run_length_bwt;
+
   // Indicator bitvectors for characters using sparse encoding.
   std::vector<sparse_vector>              sparse_bwt;
   std::vector<sparse_vector::rank_1_type> sparse_rank;
 
+  // Alternative encoding for the sparse characters. Used instead of sparse_bwt if combinedSparse().
+  SparseBWT                               sparse_combined;
+
   // The last outgoing edge from each path is marked with an 1-bit.
   fast_vector                             edges;
   fast_vector::rank_1_type                edge_rank;
@@ -231,7 +301,9 @@ public:
   fast_vector::rank_1_type                sampled_path_rank;
 
   // The last sample belonging to the same path is marked with an 1-bit.
+  // Queries access stored_samples through sample_values, which may point to a mapped file.
   sdsl::int_vector<0>                     stored_samples;
+  IntVectorView                           sample_values;
   bit_vector                              samples;
   bit_vector::select_1_type               sample_select;
 
@@ -242,12 +314,38 @@ public:
 //------------------------------------------------------------------------------
 
 private:
+  // Keeps the file alive for the structures using it.
+  std::shared_ptr<const MappedFile>       mapping;
+
   void copy(const GCSA& source);
   void setVectors();
   void initSupport();
+  void load(std::istream& in, const MappedFile* file);
+
+  // LF_fast() using packed_bwt. Does not clear the results.
+  void LF_packed(range_type range, std::vector<range_type>& results) const;
 
+  // LF(range, comp) for sparse comp values < sigma - 1 using sparse_combined.
+  // Does not clear the results.
+  void LF_sparse(range_type range, std::vector<range_type>& results) const;
+
+  void locateParallel(range_type range, std::vector<node_type>& results, size_type threads, bool sort) const;
   void locateInternal(size_type path, std::vector<node_type>& results) const;
 
+  // Locates paths [first, last - 1] by interleaving their LF() walks.
+  void locateBatch(size_type first, size_type last, std::vector<node_type>& results) const;
+
+  // Reports the samples at sampled path_node, adding steps to each.
+  inline void addSamples(size_type path_node, size_type steps, std::vector<node_type>& results) const
+  {
+    size_type sample = this->firstSample(path_node);
+    do
+    {
+      results.push_back(this->sample(sample) + steps); sample++;
+    }
+    while(!(this->lastSample(sample - 1)));
+  }
+
 //------------------------------------------------------------------------------
 
   inline range_type pathNodeRange(range_type outgoing_range) const
@@ -257,6 +355,41 @@ private:
     return outgoing_range;
   }
 
+  // The first half of LF(range, comp): returns the range of outgoing edges.
+  inline range_type outgoingRange(range_type range, comp_type comp) const
+  {
+    if(comp > 0 && comp <= this->alpha.fast_chars)
+    {
+      if(this->packed()) { return this->LF(this->packed_bwt, range, comp); }
+      else if(this->runLength()) { return this->LF(this->run_length_bwt, range, comp); }
+      else { return this->LF(this->fast_rank, range, comp); }
+    }
+    else if(this->combinedSparse()) { return this->LF(this->sparse_combined, range, comp); }
+    else { return this->LF(this->sparse_rank, range, comp); }
+  }
+
+  /*
+    Prefetch hints for the two halves of LF(range, comp). Only PackedBWT and
+    RankBitVector expose their blocks; other encodings are not prefetched.
+  */
+  inline void prefetchOutgoing(range_type range, comp_type comp) const
+  {
+    if(comp == 0 || comp > this->alpha.fast_chars) { return; }
+    if(this->packed())
+    {
+      this->packed_bwt.prefetch(range.first); this->packed_bwt.prefetch(range.second + 1);
+    }
+    else if(!(this->runLength()))
+    {
+      this->fast_bwt[comp].prefetch(range.first); this->fast_bwt[comp].prefetch(range.second + 1);
+    }
+  }
+
+  inline void prefetchPathNodes(range_type outgoing_range) const
+  {
+    this->edges.prefetch(outgoing_range.first); this->edges.prefetch(outgoing_range.second);
+  }
+
 
   // The following LF implementations return outgoing edges.
   template<class Rank>
@@ -272,6 +405,30 @@ private:
     range.second = this->LF(rank, range.second + 1, comp) - 1;
     return range;
   }
+
+  inline size_type LF(const PackedBWT& bwt, size_type i, comp_type comp) const
+  {
+    return this->alpha.C[comp] + bwt.rank(i, comp);
+  }
+
+  inline range_type LF(const PackedBWT& bwt, range_type range, comp_type comp) const
+  {
+    range.first = this->LF(bwt, range.first, comp);
+    range.second = this->LF(bwt, range.second + 1, comp) - 1;
+    return range;
+  }
+
+  inline size_type LF(const SparseBWT& bwt, size_type i, comp_type comp) const
+  {
+    return this->alpha.C[comp] + bwt.rank(i, comp);
+  }
+
+  inline range_type LF(const SparseBWT& bwt, range_type range, comp_type comp) const
+  {
+    range.first = this->LF(bwt, range.first, comp);
+    range.second = this->LF(bwt, range.second + 1, comp) - 1;
+    return range;
+  }
 };  // class GCSA
 
 //------------------------------------------------------------------------------
@@ -26,6 +26,8 @@
 #ifndef GCSA_INTERNAL_H
 #define GCSA_INTERNAL_H
 
+#include <cstring>
+#include <deque>
 #include <map>
 
 // C++ threads for DiskIO, ReadBuffer.
@@ -90,6 +92,272 @@ struct DiskIO
 
 //------------------------------------------------------------------------------
 
+/*
+  Page cache advice for sequentially processed files. The streams do not expose their
+  file descriptors, so the advice uses a separate descriptor for the same file. The
+  functions do nothing on systems without posix_fadvise() and sync_file_range(), or if
+  the file could not be opened.
+
+  prefetch() starts reading the range in the background. The other functions only have
+  an effect if TempFile::drop_cache is set. release() drops the clean pages in the range
+  from the page cache. Dirty pages must be written back before they can be dropped, so
+  writeBack() starts the writeback and releaseWritten() waits for it before dropping the
+  pages.
+*/
+
+struct PageCache
+{
+  int fd;
+
+  PageCache();
+  ~PageCache();
+
+  void open(const std::string& filename);
+  void close();
+
+  void prefetch(size_type offset, size_type bytes) const;
+  void release(size_type offset, size_type bytes) const;
+  void writeBack(size_type offset, size_type bytes) const;
+  void releaseWritten(size_type offset, size_type bytes) const;
+
+  PageCache(const PageCache&) = delete;
+  PageCache& operator= (const PageCache&) = delete;
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  Variable-length byte codes for the block codecs. Each byte stores 7 bits of the value,
+  and the high bit is set if there are more bytes. Signed values are mapped to unsigned
+  values by interleaving the positive and the negative values.
+*/
+
+struct ByteCode
+{
+  inline static void write(std::vector<byte_type>& data, size_type value)
+  {
+    while(value >= 0x80)
+    {
+      data.push_back((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    data.push_back(value);
+  }
+
+  // Returns 0 if the code extends beyond the end of the data.
+  inline static size_type read(const std::vector<byte_type>& data, size_type& i)
+  {
+    size_type value = 0;
+    for(size_type shift = 0; i < data.size(); shift += 7)
+    {
+      byte_type byte = data[i]; i++;
+      value |= (size_type)(byte & 0x7F) << shift;
+      if(byte < 0x80) { break; }
+    }
+    return value;
+  }
+
+  inline static size_type encode(size_type prev, size_type curr)
+  {
+    return (curr >= prev ? 2 * (curr - prev) : 2 * (prev - curr) - 1);
+  }
+
+  inline static size_type decode(size_type prev, size_type code)
+  {
+    return (code & 1 ? prev - (code + 1) / 2 : prev + code / 2);
+  }
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  Block-compressed files. A compressed file consists of blocks of at most BLOCK_SIZE
+  elements, each encoded separately with BlockCodec<Element>, followed by the block index.
+  The index contains the byte offset and the first element of each block, followed by
+  the sentinels (data size and element count) and the number of blocks. Because the
+  blocks may be shorter than BLOCK_SIZE, a compressed file can be appended to block by
+  block.
+*/
+
+struct BlockIndex
+{
+  std::vector<size_type> offsets, starts;
+
+  constexpr static size_type BLOCK_SIZE = 16384; // Elements.
+
+  BlockIndex();
+  void clear();
+
+  inline size_type blocks() const { return this->starts.size() - 1; }
+  inline size_type elements() const { return this->starts.back(); }
+  inline size_type bytes() const { return this->offsets.back(); }
+  inline size_type blockSize(size_type block) const { return this->starts[block + 1] - this->starts[block]; }
+
+  // Returns the block containing element i < elements().
+  size_type find(size_type i) const;
+
+  void add(size_type block_bytes, size_type block_elements);
+
+  // Writes the index at the current position / reads it from the end of the file.
+  void write(std::ostream& out) const;
+  bool read(std::istream& in);
+};
+
+/*
+  The default codec stores the elements as they are. Specializations implement the
+  actual compression. decode() returns false if the block is not valid.
+*/
+
+template<class Element>
+struct BlockCodec
+{
+  static void encode(const Element* data, size_type n, std::vector<byte_type>& output)
+  {
+    const byte_type* bytes = reinterpret_cast<const byte_type*>(data);
+    output.insert(output.end(), bytes, bytes + n * sizeof(Element));
+  }
+
+  static bool decode(const std::vector<byte_type>& input, Element* data, size_type n)
+  {
+    if(input.size() != n * sizeof(Element)) { return false; }
+    std::memcpy(reinterpret_cast<byte_type*>(data), input.data(), input.size());
+    return true;
+  }
+};
+
+// Frame-of-reference bit packing for the kmer ranks.
+template<>
+struct BlockCodec<std::uint32_t>
+{
+  static void encode(const std::uint32_t* data, size_type n, std::vector<byte_type>& output);
+  static bool decode(const std::vector<byte_type>& input, std::uint32_t* data, size_type n);
+};
+
+// Encodes the elements as a new block at the current position.
+template<class Element>
+void
+writeBlock(std::ostream& out, const Element* data, size_type n, BlockIndex& index)
+{
+  std::vector<byte_type> buffer;
+  BlockCodec<Element>::encode(data, n, buffer);
+  DiskIO::write(out, buffer.data(), buffer.size());
+  index.add(buffer.size(), n);
+}
+
+// Replaces the contents of data with the decoded block.
+template<class Element>
+bool
+readBlock(std::istream& in, const BlockIndex& index, size_type block, std::vector<Element>& data)
+{
+  std::vector<byte_type> buffer(index.offsets[block + 1] - index.offsets[block]);
+  in.seekg(index.offsets[block], std::ios_base::beg);
+  if(!DiskIO::read(in, buffer.data(), buffer.size())) { return false; }
+  data.resize(index.blockSize(block));
+  return BlockCodec<Element>::decode(buffer, data.data(), data.size());
+}
+
+//------------------------------------------------------------------------------
+
+/*
+  Random access to a file of Elements stored in the raw or the block-compressed format.
+  The last decoded block is cached.
+*/
+
+template<class Element>
+struct ElementFile
+{
+  std::ifstream        file;
+  bool                 compressed;
+  size_type            elements;
+
+  // Compressed files.
+  BlockIndex           index;
+  std::vector<Element> block_data;
+  size_type            block;
+
+  ElementFile();
+
+  bool open(const std::string& filename, bool _compressed);
+  void close();
+
+  inline size_type size() const { return this->elements; }
+
+  // Reads elements [i, i + n - 1] into data.
+  bool read(size_type i, Element* data, size_type n = 1);
+
+  ElementFile(const ElementFile&) = delete;
+  ElementFile& operator= (const ElementFile&) = delete;
+};
+
+template<class Element>
+ElementFile<Element>::ElementFile() :
+  compressed(false), elements(0), block(0)
+{
+}
+
+template<class Element>
+bool
+ElementFile<Element>::open(const std::string& filename, bool _compressed)
+{
+  this->close();
+  this->file.open(filename.c_str(), std::ios_base::binary);
+  if(!(this->file)) { return false; }
+
+  this->compressed = _compressed;
+  if(this->compressed)
+  {
+    if(!(this->index.read(this->file))) { return false; }
+    this->elements = this->index.elements();
+  }
+  else { this->elements = fileSize(this->file) / sizeof(Element); }
+
+  return true;
+}
+
+template<class Element>
+void
+ElementFile<Element>::close()
+{
+  if(this->file.is_open()) { this->file.close(); }
+  this->file.clear();
+  this->elements = 0;
+  this->index.clear();
+  sdsl::util::clear(this->block_data);
+  this->block = 0;
+}
+
+template<class Element>
+bool
+ElementFile<Element>::read(size_type i, Element* data, size_type n)
+{
+  if(n == 0) { return true; }
+  if(i + n > this->size()) { return false; }
+
+  if(!(this->compressed))
+  {
+    this->file.seekg(i * sizeof(Element), std::ios_base::beg);
+    return DiskIO::read(this->file, data, n);
+  }
+
+  for(size_type curr = this->index.find(i); n > 0; curr++)
+  {
+    if(this->block_data.empty() || this->block != curr)
+    {
+      this->block_data.clear();
+      if(!readBlock(this->file, this->index, curr, this->block_data)) { return false; }
+      this->block = curr;
+    }
+    size_type offset = i - this->index.starts[curr];
+    size_type length = std::min(n, this->block_data.size() - offset);
+    std::copy(this->block_data.begin() + offset, this->block_data.begin() + offset + length, data);
+    i += length; data += length; n -= length;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
 /*
   Generic in-memory construction from int_vector_buffer<8> and size. Not very space-efficient, as it
   duplicates the data.
@@ -355,7 +623,10 @@ BufferWindow<Element>::swap(BufferWindow<Element>& another)
   accesses after it expand the buffer until the requested position is contained in it.
 
   A separate thread is spawned for reading in the background. The reader thread stops
-  when it reaches the end of the file.
+  when it reaches the end of the file. If the file is block-compressed, the reader thread
+  also decodes the blocks. After each read, the reader thread asks the kernel to read
+  the next buffer asynchronously, so that up to two buffers are being read ahead, and
+  releases the pages it has read from the page cache (see PageCache).
 */
 
 template<class Element>
@@ -367,6 +638,10 @@ struct ReadBuffer
   // File
   std::ifstream           file;
   size_type               elements, file_offset;
+  size_type               buffer_size;
+  bool                    compressed;
+  BlockIndex              index;
+  PageCache               cache;
 
   // Reader thread.
   std::vector<Element>    read_buffer;
@@ -374,16 +649,15 @@ struct ReadBuffer
   std::condition_variable empty;  // Is read_buffer empty?
   std::thread             reader_thread;
 
-  // Read this many elements at once.
+  // Read this many elements at once by default. Refill the buffer if its size falls
+  // below half of buffer_size.
   constexpr static size_type READ_BUFFER_SIZE = MEGABYTE;
 
-  // Refill the buffer if its size falls below this threshold.
-  constexpr static size_type MINIMUM_SIZE = READ_BUFFER_SIZE / 2;
-
   ReadBuffer();
   ~ReadBuffer();
 
-  void open(const std::string& filename);
+  // Read _buffer_size elements at once.
+  void open(const std::string& filename, size_type _buffer_size = READ_BUFFER_SIZE, bool _compressed = false);
   void close();
 
   inline size_type size() const { return this->elements; }
@@ -404,6 +678,7 @@ struct ReadBuffer
   bool fill();            // Fill the read buffer.
   void read(size_type i); // Read i into buffer, possibly seeking backwards.
   void forceRead();       // Add elements into buffer, assuming that the current thread holds the mutex.
+  bool readElements();    // Read elements into read_buffer, assuming that the current thread holds the mutex.
 
   ReadBuffer(const ReadBuffer&) = delete;
   ReadBuffer& operator= (const ReadBuffer&) = delete;
@@ -413,8 +688,8 @@ template<class Element>
 ReadBuffer<Element>::ReadBuffer()
 {
   this->elements = 0; this->file_offset = 0;
-  size_type buffer_size = READ_BUFFER_SIZE;  // avoid direct use
-  this->read_buffer.reserve(buffer_size);
+  this->buffer_size = READ_BUFFER_SIZE;
+  this->compressed = false;
 }
 
 template<class Element>
@@ -432,7 +707,7 @@ readerThread(ReadBuffer<Element>* buffer)
 
 template<class Element>
 void
-ReadBuffer<Element>::open(const std::string& filename)
+ReadBuffer<Element>::open(const std::string& filename, size_type _buffer_size, bool _compressed)
 {
   if(this->file.is_open())
   {
@@ -446,8 +721,21 @@ ReadBuffer<Element>::open(const std::string& filename)
     std::cerr << "ReadBuffer::open(): Cannot open input file " << filename << std::endl;
     std::exit(EXIT_FAILURE);
   }
-  this->elements = fileSize(this->file) / sizeof(Element);
+  this->compressed = _compressed;
+  if(this->compressed)
+  {
+    if(!(this->index.read(this->file)))
+    {
+      std::cerr << "ReadBuffer::open(): Invalid block index in " << filename << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    this->elements = this->index.elements();
+  }
+  else { this->elements = fileSize(this->file) / sizeof(Element); }
+  this->cache.open(filename);
   this->file_offset = 0;
+  this->buffer_size = std::max(_buffer_size, (size_type)1);
+  this->read_buffer.reserve(this->buffer_size);
 
   this->reader_thread = std::thread(readerThread<Element>, this);
 }
@@ -465,7 +753,9 @@ ReadBuffer<Element>::close()
   if(this->reader_thread.joinable()) { this->reader_thread.join(); }
 
   this->file.close();
+  this->cache.close();
   this->elements = 0;
+  this->index.clear();
 
   sdsl::util::clear(this->buffer);
 }
@@ -485,13 +775,13 @@ ReadBuffer<Element>::seek(size_type i)
     if(this->file_offset != i + this->read_buffer.size())
     {
       this->read_buffer.clear();
-      this->file.seekg(i * sizeof(Element), std::ios_base::beg);
+      if(!(this->compressed)) { this->file.seekg(i * sizeof(Element), std::ios_base::beg); }
       this->file_offset = i;
     }
   }
 
   // Force read but only if there is still something to read.
-  if(this->buffer.size() < MINIMUM_SIZE && i + this->buffer.size() < this->size())
+  if(this->buffer.size() < this->buffer_size / 2 && i + this->buffer.size() < this->size())
   {
     std::unique_lock<std::mutex> lock(this->mtx);
     this->forceRead();
@@ -506,14 +796,11 @@ ReadBuffer<Element>::fill()
   std::unique_lock<std::mutex> lock(this->mtx);
   this->empty.wait(lock, [this]() { return read_buffer.empty(); } );
 
-  size_type read_buffer_size = READ_BUFFER_SIZE;  // avoid direct use
-  this->read_buffer.resize(std::min(read_buffer_size, this->size() - this->file_offset));
-  if(!DiskIO::read(this->file, this->read_buffer.data(), this->read_buffer.size()))
+  if(!(this->readElements()))
   {
     std::cerr << "ReadBuffer::fill(): Unexpected EOF" << std::endl;
     std::exit(EXIT_FAILURE);
   }
-  this->file_offset += this->read_buffer.size();
 
   return (this->file_offset >= this->size());
 }
@@ -536,34 +823,74 @@ ReadBuffer<Element>::forceRead()
 {
   if(this->read_buffer.empty())
   {
-    size_type read_buffer_size = READ_BUFFER_SIZE;  // avoid direct use
-    this->read_buffer.resize(std::min(read_buffer_size, this->size() - this->file_offset));
-    if(!DiskIO::read(this->file, this->read_buffer.data(), this->read_buffer.size()))
+    if(!(this->readElements()))
     {
       std::cerr << "ReadBuffer::forceRead(): Unexpected EOF" << std::endl;
       std::exit(EXIT_FAILURE);
     }
-    this->file_offset += this->read_buffer.size();
   }
 
   this->buffer.insert(this->read_buffer.begin(), this->read_buffer.end());
   this->read_buffer.clear();
 }
 
+template<class Element>
+bool
+ReadBuffer<Element>::readElements()
+{
+  size_type n = std::min(this->buffer_size, this->size() - this->file_offset);
+  size_type first_byte = 0, last_byte = 0; // The byte range we have read.
+  if(this->compressed)
+  {
+    // Decode full blocks, skipping the elements before file_offset in the first block.
+    std::vector<Element> block_data;
+    this->read_buffer.clear();
+    size_type block = (n > 0 ? this->index.find(this->file_offset) : 0);
+    first_byte = this->index.offsets[block];
+    for(; this->read_buffer.size() < n; block++)
+    {
+      if(!readBlock(this->file, this->index, block, block_data)) { return false; }
+      size_type skip = (this->read_buffer.empty() ? this->file_offset - this->index.starts[block] : 0);
+      this->read_buffer.insert(this->read_buffer.end(), block_data.begin() + skip, block_data.end());
+    }
+    last_byte = this->index.offsets[block];
+  }
+  else
+  {
+    this->read_buffer.resize(n);
+    if(!DiskIO::read(this->file, this->read_buffer.data(), this->read_buffer.size())) { return false; }
+    first_byte = this->file_offset * sizeof(Element);
+    last_byte = first_byte + n * sizeof(Element);
+  }
+  this->file_offset += this->read_buffer.size();
+
+  if(this->file_offset < this->size()) { this->cache.prefetch(last_byte, last_byte - first_byte); }
+  this->cache.release(first_byte, last_byte - first_byte);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 
 /*
-  A simple wrapper for buffered writing of elementary types.
+  A simple wrapper for buffered writing of elementary types. When the buffer is full,
+  it is handed over to a writer thread, and the main thread continues with another
+  buffer. Up to WRITE_QUEUE_SIZE full buffers can wait for the writer thread, and the
+  writer thread keeps one of the written buffers for reuse. If the file is compressed,
+  the writer thread encodes the buffer as blocks of at most BlockIndex::BLOCK_SIZE
+  elements, and close() writes the block index.
+
+  If TempFile::drop_cache is set, the writer thread starts the writeback of each buffer
+  after writing it and drops the previous buffer from the page cache (see PageCache).
 */
 
 template<class Element>
 struct WriteBuffer
 {
   WriteBuffer();
-  explicit WriteBuffer(const std::string& filename, size_type _buffer_size = MEGABYTE);
+  explicit WriteBuffer(const std::string& filename, size_type _buffer_size = MEGABYTE, bool _compressed = false);
   ~WriteBuffer();
 
-  void open(const std::string& filename, size_type _buffer_size = MEGABYTE);
+  void open(const std::string& filename, size_type _buffer_size = MEGABYTE, bool _compressed = false);
   void close();
 
   inline size_type size() const { return this->elements; }
@@ -571,16 +898,35 @@ struct WriteBuffer
   inline void push_back(Element value)
   {
     this->buffer.push_back(value); this->elements++;
-    if(buffer.size() >= this->buffer_size)
-    {
-      DiskIO::write(this->file, this->buffer.data(), this->buffer.size());
-      this->buffer.clear();
-    }
+    if(buffer.size() >= this->buffer_size) { this->flush(); }
   }
 
-  std::ofstream        file;
-  std::vector<Element> buffer;
-  size_type            buffer_size, elements;
+  // Main thread.
+  std::vector<Element>    buffer;
+  size_type               buffer_size, elements;
+
+  // File.
+  std::ofstream           file;
+  bool                    compressed;
+  BlockIndex              index;
+  PageCache               cache;
+  size_type               written_bytes, released_bytes;
+
+  // Writer thread.
+  std::deque<std::vector<Element>> write_queue;
+  std::vector<Element>    spare_buffer;
+  bool                    closing;
+  std::mutex              mtx;
+  std::condition_variable ready;  // Has the state of write_queue changed?
+  std::thread             writer_thread;
+
+  constexpr static size_type WRITE_QUEUE_SIZE = 2;
+
+  // Internal functions.
+  void flush();                                   // Hand the buffer over to the writer thread.
+  bool write();                                   // Write the first buffer in the queue. Returns true when done.
+  void writeElements(const std::vector<Element>& data);
+  void releasePages(bool final);                  // Page cache advice after writing.
 
   WriteBuffer(const WriteBuffer&) = delete;
   WriteBuffer& operator= (const WriteBuffer&) = delete;
@@ -588,14 +934,15 @@ struct WriteBuffer
 
 template<class Element>
 WriteBuffer<Element>::WriteBuffer() :
-  buffer_size(0), elements(0)
+  buffer_size(0), elements(0), compressed(false), written_bytes(0), released_bytes(0), closing(false)
 {
 }
 
 template<class Element>
-WriteBuffer<Element>::WriteBuffer(const std::string& filename, size_type _buffer_size)
+WriteBuffer<Element>::WriteBuffer(const std::string& filename, size_type _buffer_size, bool _compressed) :
+  buffer_size(0), elements(0), compressed(false), written_bytes(0), released_bytes(0), closing(false)
 {
-  this->open(filename, _buffer_size);
+  this->open(filename, _buffer_size, _compressed);
 }
 
 template<class Element>
@@ -606,31 +953,132 @@ WriteBuffer<Element>::~WriteBuffer()
 
 template<class Element>
 void
-WriteBuffer<Element>::open(const std::string& filename, size_type _buffer_size)
+writerThread(WriteBuffer<Element>* buffer)
 {
+  while(!(buffer->write()));
+}
+
+template<class Element>
+void
+WriteBuffer<Element>::open(const std::string& filename, size_type _buffer_size, bool _compressed)
+{
+  if(this->file.is_open())
+  {
+    std::cerr << "WriteBuffer::open(): The file is already open" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
   this->file.open(filename.c_str(), std::ios_base::binary);
   if(!(this->file))
   {
     std::cerr << "WriteBuffer::open(): Cannot open output file " << filename << std::endl;
     std::exit(EXIT_FAILURE);
   }
+  if(TempFile::drop_cache) { this->cache.open(filename); }
+  this->written_bytes = 0; this->released_bytes = 0;
 
-  this->buffer_size = _buffer_size; this->elements = 0;
+  this->buffer_size = std::max(_buffer_size, (size_type)1); this->elements = 0;
   this->buffer.reserve(this->buffer_size);
+  this->compressed = _compressed;
+  this->index.clear();
+
+  this->closing = false;
+  this->writer_thread = std::thread(writerThread<Element>, this);
 }
 
 template<class Element>
 void
 WriteBuffer<Element>::close()
 {
-  if(this->buffer.size() > 0)
-  {
-    DiskIO::write(this->file, this->buffer.data(), this->buffer.size());
-  }
+  if(!(this->file.is_open())) { return; }
+
+  // Let the writer thread finish with the queue.
+  this->mtx.lock();
+  this->closing = true;
+  this->ready.notify_all();
+  this->mtx.unlock();
+  if(this->writer_thread.joinable()) { this->writer_thread.join(); }
+
+  if(this->buffer.size() > 0) { this->writeElements(this->buffer); }
+  if(this->compressed) { this->index.write(this->file); }
+  this->releasePages(true);
   this->file.close();
+  this->cache.close();
   sdsl::util::clear(this->buffer);
+  sdsl::util::clear(this->spare_buffer);
   this->buffer_size = 0;
   this->elements = 0;
+  this->index.clear();
+}
+
+template<class Element>
+void
+WriteBuffer<Element>::flush()
+{
+  std::unique_lock<std::mutex> lock(this->mtx);
+  this->ready.wait(lock, [this]() { return (write_queue.size() < WRITE_QUEUE_SIZE); } );
+  this->write_queue.push_back(std::vector<Element>());
+  this->write_queue.back().swap(this->buffer);
+  this->buffer.swap(this->spare_buffer);
+  this->ready.notify_all();
+  lock.unlock();
+
+  this->buffer.reserve(this->buffer_size);
+}
+
+template<class Element>
+bool
+WriteBuffer<Element>::write()
+{
+  std::unique_lock<std::mutex> lock(this->mtx);
+  this->ready.wait(lock, [this]() { return (!(write_queue.empty()) || closing); } );
+  if(this->write_queue.empty()) { return true; }
+
+  // Only the writer thread uses the file and the front of the queue.
+  std::vector<Element>& data = this->write_queue.front();
+  lock.unlock();
+  this->writeElements(data);
+  this->releasePages(false);
+  data.clear();
+  lock.lock();
+
+  if(this->spare_buffer.capacity() == 0) { this->spare_buffer.swap(data); }
+  this->write_queue.pop_front();
+  this->ready.notify_all();
+  return false;
+}
+
+template<class Element>
+void
+WriteBuffer<Element>::writeElements(const std::vector<Element>& data)
+{
+  if(this->compressed)
+  {
+    for(size_type i = 0; i < data.size(); i += BlockIndex::BLOCK_SIZE)
+    {
+      size_type n = std::min(BlockIndex::BLOCK_SIZE, data.size() - i);
+      writeBlock(this->file, data.data() + i, n, this->index);
+    }
+  }
+  else { DiskIO::write(this->file, data.data(), data.size()); }
+}
+
+/*
+  The pages written in the previous call should have been written back by now, so
+  waiting for them should not take long. In the final call, we wait for everything.
+*/
+template<class Element>
+void
+WriteBuffer<Element>::releasePages(bool final)
+{
+  if(this->cache.fd < 0) { return; }
+
+  this->file.flush();
+  size_type end = this->file.tellp();
+  this->cache.writeBack(this->written_bytes, end - this->written_bytes);
+  size_type release_end = (final ? end : this->written_bytes);
+  this->cache.releaseWritten(this->released_bytes, release_end - this->released_bytes);
+  this->released_bytes = release_end; this->written_bytes = end;
 }
 
 //------------------------------------------------------------------------------
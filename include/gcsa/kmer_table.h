@@ -0,0 +1,156 @@
+/*
+  Copyright (c) 2019 Jouni Sirén
+
+  Author: Jouni Siren <jouni.siren@iki.fi>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef GCSA_KMER_TABLE_H
+#define GCSA_KMER_TABLE_H
+
+#include <gcsa/gcsa.h>
+
+namespace gcsa
+{
+
+/*
+  kmer_table.h: Lookup table for the path ranges of short patterns.
+*/
+
+//------------------------------------------------------------------------------
+
+/*
+  The table stores the path range of every pattern of length k over the fast characters
+  (comp values 1 to fast_chars) in a GCSA index. Backward searching can then start from
+  the range of the last k characters of the pattern instead of taking k LF() steps.
+  The table uses 2 * fast_chars^k * log(n) bits.
+
+  The kmers are encoded as integers in base fast_chars, with the first character as the
+  most significant digit.
+*/
+
+class KMerTable
+{
+public:
+  typedef gcsa::size_type size_type;
+
+//------------------------------------------------------------------------------
+
+  KMerTable();
+  KMerTable(const KMerTable& source);
+  KMerTable(KMerTable&& source);
+  ~KMerTable();
+
+  void swap(KMerTable& another);
+  KMerTable& operator=(const KMerTable& source);
+  KMerTable& operator=(KMerTable&& source);
+
+  size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const;
+  void load(std::istream& in);
+
+  const static std::string EXTENSION; // .ktab
+
+  constexpr static uint32_t  TAG            = 0x6C5A4B54;
+  constexpr static uint32_t  VERSION        = 1;
+  constexpr static size_type DEFAULT_LENGTH = 10;
+  constexpr static size_type MAX_ENTRIES    = 1 << 28;
+
+//------------------------------------------------------------------------------
+
+  /*
+    Builds the table for the longest kmer length up to the given length such that the
+    table has at most MAX_ENTRIES entries. The table is specific to the index.
+  */
+  explicit KMerTable(const GCSA& index, size_type length = DEFAULT_LENGTH);
+
+//------------------------------------------------------------------------------
+
+  inline size_type length() const { return this->kmer_length; }
+  inline size_type size() const { return this->starts.size(); }
+  inline bool empty() const { return (this->size() == 0); }
+
+  inline range_type range(size_type code) const
+  {
+    return range_type(this->starts[code], this->limits[code] - 1);
+  }
+
+  /*
+    Returns the same range as index.find(begin, end), though an empty range may be
+    represented differently. If the pattern is at least length() characters long and
+    the last length() characters are fast characters, the search starts from the table
+    entry for the suffix.
+  */
+  template<class Iterator>
+  range_type find(const GCSA& index, Iterator begin, Iterator end) const
+  {
+    if(this->empty()) { return index.find(begin, end); }
+
+    Iterator curr = end;
+    size_type code = 0, multiplier = 1;
+    for(size_type i = 0; i < this->length(); i++)
+    {
+      if(curr == begin) { return index.find(begin, end); }
+      --curr;
+      comp_type comp = index.alpha.char2comp[*curr];
+      if(comp == 0 || comp > this->fast_chars) { return index.find(begin, end); }
+      code += (comp - 1) * multiplier; multiplier *= this->fast_chars;
+    }
+
+    range_type range = this->range(code);
+    while(!Range::empty(range) && curr != begin)
+    {
+      --curr;
+      range = index.LF(range, index.alpha.char2comp[*curr]);
+    }
+
+    return range;
+  }
+
+  template<class Container>
+  range_type find(const GCSA& index, const Container& pattern) const
+  {
+    return this->find(index, pattern.begin(), pattern.end());
+  }
+
+  template<class Element>
+  range_type find(const GCSA& index, const Element* pattern, size_type length) const
+  {
+    return this->find(index, pattern, pattern + length);
+  }
+
+//------------------------------------------------------------------------------
+
+  size_type           kmer_length;
+  size_type           fast_chars;
+
+  // The range for kmer i is [starts[i], limits[i] - 1]. Empty ranges are stored as (0, 0).
+  sdsl::int_vector<0> starts, limits;
+
+//------------------------------------------------------------------------------
+
+private:
+  void copy(const KMerTable& source);
+};  // class KMerTable
+
+//------------------------------------------------------------------------------
+
+} // namespace gcsa
+
+#endif // GCSA_KMER_TABLE_H
@@ -107,6 +107,14 @@ public:
   size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const;
   void load(std::istream& in);
 
+  /*
+    Memory-maps the LCP file. If the file has the MAPPABLE flag, the array is used
+    directly from the mapping. Otherwise it is loaded normally. Returns false if the
+    file cannot be mapped.
+  */
+  bool map(const std::string& filename);
+  inline bool mapped() const { return (this->mapping != nullptr); }
+
   const static std::string EXTENSION; // .lcp
 
 //------------------------------------------------------------------------------
@@ -122,11 +130,11 @@ public:
 //------------------------------------------------------------------------------
 
   inline size_type size() const { return this->header.size; }
-  inline size_type values() const { return this->data.size(); }
+  inline size_type values() const { return this->lcp_values.size(); }
   inline size_type levels() const { return this->offsets.size() - 1; }
   inline size_type branching() const { return this->header.branching; }
 
-  inline size_type operator[] (size_type i) const { return this->data[i]; }
+  inline size_type operator[] (size_type i) const { return this->lcp_values[i]; }
 
 //------------------------------------------------------------------------------
 
@@ -165,12 +173,12 @@ public:
     if(range.second + 1 < this->size())
     {
       return node_type(range.first, range.second,
-                       this->data[range.first], this->data[range.second + 1],
+                       (*this)[range.first], (*this)[range.second + 1],
                        node_type::UNKNOWN);
     }
     else
     {
-      return node_type(range.first, range.second, this->data[range.first], 0, node_type::UNKNOWN);
+      return node_type(range.first, range.second, (*this)[range.first], 0, node_type::UNKNOWN);
     }
   }
 
@@ -179,18 +187,49 @@ public:
 
 //------------------------------------------------------------------------------
 
+  // The scan kernel in use: "avx2", "sse2", or "portable".
+  static const std::string& kernelName();
+
   /*
     We store a k-ary range minimum tree over the LCP array. Each node is identified by
-    its position in the data array. Level i occupies range [offsets[i], offsets[i + 1] - 1]
-    in the array. Level 0 is the leaves (the LCP array).
+    its position in the data array. Level i occupies range [offsets[i], level_ends[i] - 1]
+    in the array, followed by padding up to offsets[i + 1]. Level 0 is the leaves (the LCP
+    array). Queries access the data through lcp_values, which may point to a memory-mapped
+    file.
+
+    In version 2, the values use 8 bits, or 16 bits if they do not fit in a byte. The
+    levels after the leaves start at multiples of LEVEL_ALIGNMENT. With 8-bit values and
+    a branching factor that is a multiple of 64, the children of each node then start
+    at a 64-byte boundary relative to the array, which is page-aligned in the mappable
+    layout. The padding contains the maximal value.
   */
 
-  LCPHeader            header;
-  sdsl::int_vector<0>  data;
-  sdsl::int_vector<64> offsets;
+  LCPHeader              header;
+  sdsl::int_vector<0>    data;
+  IntVectorView          lcp_values;
+  sdsl::int_vector<64>   offsets;
+  std::vector<size_type> level_ends;  // Not serialized.
+
+  constexpr static size_type LEVEL_ALIGNMENT = 64;
 
 private:
+  // Keeps the file alive while lcp_values points to it.
+  std::shared_ptr<const MappedFile> mapping;
+
   void copy(const LCPArray& source);
+  void setVectors();
+  void setLevelEnds();
+  void load(std::istream& in, const MappedFile* file);
+
+  // Initializes offsets and level_ends for the current size and branching factor.
+  // Returns the total number of values.
+  size_type initLevels();
+
+  // Computes the internal nodes of the range minimum tree from the leaves.
+  void buildTree();
+
+  // Converts a version 1 body to the current layout.
+  void upgrade();
 };  // class LCPArray
 
 //------------------------------------------------------------------------------
@@ -44,16 +44,37 @@ struct PathLabel
   typedef std::uint32_t rank_type;
 
   // This should be at least 1 << ConstructionParameters::MAX_STEPS.
-  constexpr static size_type LABEL_LENGTH = 16;
+  constexpr static size_type LABEL_LENGTH = 128;
 
   // Labels starting with NO_RANK will be after real labels in lexicographic order.
   // We also use NO_RANK for padding last labels.
   constexpr static rank_type NO_RANK = ~(rank_type)0;
 
+  // Path labels have at most this many ranks after the given number of doubling steps.
+  inline static size_type length(size_type steps)
+  {
+    return std::min((size_type)1 << steps, LABEL_LENGTH);
+  }
+};
+
+/*
+  A path label with space for LENGTH ranks. The label types used during merging and
+  GCSA construction are templated by the label length, so that the early doubling
+  steps do not pay for the space and the comparisons of maximum-length labels.
+*/
+
+template<size_type LENGTH>
+struct SizedLabel
+{
+  typedef PathLabel::rank_type rank_type;
+
+  constexpr static size_type LABEL_LENGTH = LENGTH;
+  constexpr static rank_type NO_RANK = PathLabel::NO_RANK;
+
   rank_type label[LABEL_LENGTH];
   bool      first;
 
-  inline bool operator< (const PathLabel& another) const
+  inline bool operator< (const SizedLabel& another) const
   {
     for(size_type i = 0; i < LABEL_LENGTH; i++)
     {
@@ -62,7 +83,7 @@ struct PathLabel
     return (this->first && !(another.first));
   }
 
-  inline bool operator<= (const PathLabel& another) const
+  inline bool operator<= (const SizedLabel& another) const
   {
     for(size_type i = 0; i < LABEL_LENGTH; i++)
     {
@@ -72,6 +93,30 @@ struct PathLabel
   }
 };
 
+template<size_type LENGTH> constexpr size_type SizedLabel<LENGTH>::LABEL_LENGTH;
+template<size_type LENGTH> constexpr typename SizedLabel<LENGTH>::rank_type SizedLabel<LENGTH>::NO_RANK;
+
+/*
+  Calls function.template run<LENGTH>() with LENGTH = PathLabel::length(steps) as a
+  compile-time constant.
+*/
+template<class Function>
+inline void
+withLabelLength(size_type steps, Function& function)
+{
+  switch(PathLabel::length(steps))
+  {
+  case 1:  function.template run<1>(); break;
+  case 2:  function.template run<2>(); break;
+  case 4:  function.template run<4>(); break;
+  case 8:  function.template run<8>(); break;
+  case 16: function.template run<16>(); break;
+  case 32: function.template run<32>(); break;
+  case 64: function.template run<64>(); break;
+  default: function.template run<PathLabel::LABEL_LENGTH>(); break;
+  }
+}
+
 //------------------------------------------------------------------------------
 
 /*
@@ -242,6 +287,18 @@ struct FromGetter
   }
 };
 
+/*
+  Block codec for compressed path files. The from nodes are delta-coded, the to nodes
+  are stored relative to the from nodes, and the pointers relative to the end of the
+  label of the previous path.
+*/
+template<>
+struct BlockCodec<PathNode>
+{
+  static void encode(const PathNode* data, size_type n, std::vector<byte_type>& output);
+  static bool decode(const std::vector<byte_type>& input, PathNode* data, size_type n);
+};
+
 //------------------------------------------------------------------------------
 
 struct LCP
@@ -288,6 +345,9 @@ struct LCP
   labels. The PathNodes in each file are sorted by their labels, and the read() member
   functions will also return the PathNodes in sorted order. The labels are stored in
   the same order as the PathNodes.
+
+  If compressed is set, the files use the block-compressed format from internal.h.
+  The size of the graph is still measured in the raw format.
 */
 
 struct PathGraph
@@ -300,20 +360,27 @@ struct PathGraph
 
   size_type unique, redundant, unsorted, nondeterministic;
 
-  bool delete_files;
+  bool delete_files, compressed;
 
   constexpr static size_type UNKNOWN = ~(size_type)0;
   const static std::string PREFIX;  // gcsa
 
-  PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_labels);
-  PathGraph(size_type file_count, size_type path_order, size_type steps);
+  PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_labels, bool compress = false);
+
+  /*
+    Reads each input file only once. Also returns the keys and the start nodes as
+    InputGraph::readKeys(keys) and InputGraph::readFrom(from_nodes, true) would.
+    Works with streaming input.
+  */
+  PathGraph(InputGraph& source, std::vector<key_type>& keys, std::vector<node_type>& from_nodes, bool compress = false);
+  PathGraph(size_type file_count, size_type path_order, size_type steps, bool compress = false);
   PathGraph(const std::string& path_name, const std::string& rank_name);  // For debugging.
   ~PathGraph();
 
   void clear();
   void swap(PathGraph& another);
 
-  void open(std::ifstream& path_file, std::ifstream& rank_file, size_type file) const;
+  void open(ElementFile<PathNode>& path_file, ElementFile<PathNode::rank_type>& rank_file, size_type file) const;
 
   inline size_type size() const { return this->path_count; }
   inline size_type ranks() const { return this->rank_count; }
@@ -354,10 +421,12 @@ struct PathGraph
 
 struct MergedGraph
 {
+  typedef InputGraph::lcp_type lcp_type;
+
   std::string path_name, rank_name, from_name, lcp_name;
 
   size_type path_count, rank_count, from_count;
-  size_type order;
+  size_type order, doubling_steps;
 
   std::vector<size_type> next;      // paths[next[comp]] is the first path starting with comp.
   std::vector<size_type> next_from; // Where to find the corresponding additional start nodes.
@@ -372,6 +441,9 @@ struct MergedGraph
       MergedGraph merged_graph(source, mapper, kmer_lcp, total_size_limit - source.bytes())
   */
   MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, const LCP& kmer_lcp, size_type size_limit);
+
+  // Creates an empty graph. Used for parallel construction.
+  MergedGraph(size_type path_order, size_type steps, size_type sigma);
   ~MergedGraph();
 
   void clear();
@@ -380,11 +452,12 @@ struct MergedGraph
   inline size_type ranks() const { return this->rank_count; }
   inline size_type extra() const { return this->from_count; }
   inline size_type k() const { return this->order; }
+  inline size_type step() const { return this->doubling_steps; }
 
   inline size_type path_bytes() const { return this->size() * sizeof(PathNode); }
   inline size_type rank_bytes() const { return this->ranks() * sizeof(PathNode::rank_type); }
   inline size_type from_bytes() const { return this->extra() * sizeof(range_type); }
-  inline size_type lcp_bytes() const { return this->size(); }
+  inline size_type lcp_bytes() const { return this->size() * sizeof(lcp_type); }
 
   inline size_type bytes() const
   {
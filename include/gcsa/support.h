@@ -40,14 +40,15 @@ namespace gcsa
 /*
   Known bottlenecks for increasing the maximum number of doubling steps:
   - PathNode has enough space for 7 steps, or 8 steps if we store order - 1 instead of order.
-  - PathLabel always reserves space for a maximum-length rank sequence.
-  - The LCP array is generated as a byte array, limiting prefix-doubling to 4 steps.
+  - PathLabel::LABEL_LENGTH and withLabelLength() must cover 1 << MAX_STEPS ranks.
+  - The LCP array is generated with 16-bit values, which is enough for 7 steps with
+    the maximum kmer length.
 */
 
 struct ConstructionParameters
 {
   constexpr static size_type DOUBLING_STEPS = 4;
-  constexpr static size_type MAX_STEPS      = 4;
+  constexpr static size_type MAX_STEPS      = 7;
   constexpr static size_type SIZE_LIMIT     = 2048;   // Gigabytes.
   constexpr static size_type ABSOLUTE_LIMIT = 16384;  // Gigabytes.
   constexpr static size_type SAMPLE_PERIOD  = 64;
@@ -60,16 +61,34 @@ struct ConstructionParameters
   void reduceLimit(size_type bytes);
   void setSamplePeriod(size_type period);
   void setLCPBranching(size_type factor);
+  void setPackedBWT(bool packed);
+  void setRunLengthBWT(bool run_length);
+  void setCombinedSparse(bool combined);
+  void setMappable(bool mappable);
+  void setCompressTemp(bool compress);
+  void setRankVectors(bool rank_vectors);
 
   size_type getSteps() const { return this->doubling_steps; }
   size_type getLimitBytes() const { return this->size_limit; }
   size_type getSamplePeriod() const { return this->sample_period; }
   size_type getLCPBranching() const { return this->lcp_branching; }
+  bool getPackedBWT() const { return this->packed_bwt; }
+  bool getRunLengthBWT() const { return this->run_length_bwt; }
+  bool getCombinedSparse() const { return this->combined_sparse; }
+  bool getMappable() const { return this->mappable; }
+  bool getCompressTemp() const { return this->compress_temp; }
+  bool getRankVectors() const { return this->rank_vectors; }
 
   size_type doubling_steps;
   size_type size_limit;
   size_type sample_period;
   size_type lcp_branching;
+  bool      packed_bwt;     // Use PackedBWT for the fast characters.
+  bool      run_length_bwt; // Use RunLengthVector for the fast characters.
+  bool      combined_sparse; // Use SparseBWT for the sparse characters.
+  bool      mappable;       // Use the page-aligned layout for the large arrays.
+  bool      compress_temp;  // Use block-compressed temporary files for prefix-doubling.
+  bool      rank_vectors;   // Use RankBitVector for fast_bwt, edges, and sampled_paths.
 };
 
 //------------------------------------------------------------------------------
@@ -358,6 +377,516 @@ SadaSparse::SadaSparse(const Container& source)
 
 //------------------------------------------------------------------------------
 
+/*
+  A bitvector with rank support, optionally used for fast_bwt, edges, and sampled_paths
+  in GCSA (see FastBitVector). Each 64-byte block starts with the number of 1-bits before the block, followed by
+  448 bits of the bitvector, so a rank query accesses a single cache line. There is
+  always a block after the last position to support rank(n). The blocks are stored
+  in a WordBuffer, which may use huge pages according to HugePages::mode, or used
+  directly from a memory-mapped file.
+
+  The in-block count uses inline popcounts over all data words with masks instead of a
+  loop over the full words. The number of full words varies between queries, so a loop
+  would mispredict a branch in most rank queries.
+
+  The vector serves as its own rank support through rank_1_type, which has the same
+  interface as the SDSL rank supports.
+*/
+
+class RankBitVector
+{
+public:
+  typedef gcsa::size_type size_type;
+
+  constexpr static size_type BLOCK_WORDS = 8;
+  constexpr static size_type DATA_WORDS  = BLOCK_WORDS - 1;
+  constexpr static size_type BLOCK_BITS  = DATA_WORDS * WORD_BITS;
+  constexpr static size_type ALIGNMENT   = WordBuffer::ALIGNMENT;  // Bytes.
+
+  RankBitVector();
+  RankBitVector(const RankBitVector& source);
+  RankBitVector(RankBitVector&& source);
+  ~RankBitVector();
+
+  explicit RankBitVector(const sdsl::bit_vector& source);
+
+  void swap(RankBitVector& another);
+  RankBitVector& operator=(const RankBitVector& source);
+  RankBitVector& operator=(RankBitVector&& source);
+
+  // The blocks are aligned at 'alignment' bytes in the file (see serializeWords()).
+  size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "",
+                      size_type position = 0, size_type alignment = ALIGNMENT) const;
+
+  // If mapping is not null, the blocks will be used directly from the mapping.
+  void load(std::istream& in, const MappedFile* mapping = nullptr);
+
+  inline size_type size() const { return this->elements; }
+  inline size_type blocks() const { return this->block_count; }
+
+  inline bool operator[](size_type i) const
+  {
+    const std::uint64_t* block = this->block(i / BLOCK_BITS);
+    size_type offset = i % BLOCK_BITS;
+    return (block[1 + offset / WORD_BITS] >> (offset % WORD_BITS)) & 1;
+  }
+
+  // The number of 1-bits in [0, i).
+  inline size_type rank(size_type i) const
+  {
+    const std::uint64_t* block = this->block(i / BLOCK_BITS);
+    size_type offset = i % BLOCK_BITS, full = offset / WORD_BITS;
+    size_type res = block[0];
+    for(size_type j = 0; j < DATA_WORDS; j++)
+    {
+      res += sdsl::bits::cnt(block[1 + j] & -static_cast<std::uint64_t>(j < full));
+    }
+    return res + sdsl::bits::cnt(block[1 + full] & ((std::uint64_t(1) << (offset % WORD_BITS)) - 1));
+  }
+
+  // Hints that the block for rank(i) will be needed soon.
+  inline void prefetch(size_type i) const
+  {
+    __builtin_prefetch(this->block(i / BLOCK_BITS));
+  }
+
+  class rank_1_type
+  {
+  public:
+    typedef gcsa::size_type size_type;
+
+    explicit rank_1_type(const RankBitVector* v = nullptr) : vector(v) {}
+
+    inline size_type rank(size_type i) const { return this->vector->rank(i); }
+    inline size_type operator()(size_type i) const { return this->vector->rank(i); }
+
+    void set_vector(const RankBitVector* v = nullptr) { this->vector = v; }
+    void swap(rank_1_type&) {}
+
+    size_type serialize(std::ostream&, sdsl::structure_tree_node* v = nullptr, std::string name = "") const
+    {
+      sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+      sdsl::structure_tree::add_size(child, 0);
+      return 0;
+    }
+    void load(std::istream&, const RankBitVector* v = nullptr) { this->vector = v; }
+
+  private:
+    const RankBitVector* vector;
+  };
+
+private:
+  size_type                  elements, block_count;
+  WordBuffer                 data;
+  const std::uint64_t*       first_block;
+
+  inline const std::uint64_t* block(size_type i) const
+  {
+    return this->first_block + i * BLOCK_WORDS;
+  }
+
+  void copy(const RankBitVector& source);
+  std::uint64_t* allocate(size_type n); // Returns the first block.
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  The bitvector used for fast_bwt, edges, and sampled_paths in GCSA. By default, it is
+  sdsl::bit_vector_il<512>, which keeps the file format compatible with earlier indexes.
+  With flag GCSAHeader::RANK_VECTORS, it is a RankBitVector, which can be used from a
+  memory-mapped file and supports prefetch(). The layout is chosen at construction and
+  passed to load().
+
+  rank_1_type stores the rank support of bit_vector_il, so the serialized layout is the
+  same as with the SDSL types. With RankBitVector, the rank support is empty.
+*/
+
+class FastBitVector
+{
+public:
+  typedef gcsa::size_type       size_type;
+  typedef sdsl::bit_vector_il<> plain_vector;
+
+  FastBitVector();
+  FastBitVector(const sdsl::bit_vector& source, bool rank_vector);
+
+  void swap(FastBitVector& another);
+
+  // The alignment only applies to RankBitVector (see serializeWords()).
+  size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "",
+                      size_type position = 0, size_type alignment = RankBitVector::ALIGNMENT) const;
+
+  // If mapping is not null, a RankBitVector will be used directly from the mapping.
+  void load(std::istream& in, bool rank_vector, const MappedFile* mapping = nullptr);
+
+  inline bool rankVector() const { return this->rank_vector; }
+  inline size_type size() const { return (this->rank_vector ? this->blocks.size() : this->plain.size()); }
+
+  inline bool operator[](size_type i) const
+  {
+    return (this->rank_vector ? this->blocks[i] : this->plain[i]);
+  }
+
+  // Hints that the data for rank(i) will be needed soon. bit_vector_il does not expose
+  // its blocks, so this only works with RankBitVector.
+  inline void prefetch(size_type i) const
+  {
+    if(this->rank_vector) { this->blocks.prefetch(i); }
+  }
+
+  class rank_1_type
+  {
+  public:
+    typedef gcsa::size_type size_type;
+
+    explicit rank_1_type(const FastBitVector* v = nullptr) :
+      blocks(v != nullptr && v->rank_vector ? &(v->blocks) : nullptr),
+      plain_rank(v != nullptr && !(v->rank_vector) ? &(v->plain) : nullptr)
+    {
+    }
+
+    inline size_type rank(size_type i) const
+    {
+      return (this->blocks != nullptr ? this->blocks->rank(i) : this->plain_rank(i));
+    }
+    inline size_type operator()(size_type i) const { return this->rank(i); }
+
+    void set_vector(const FastBitVector* v = nullptr)
+    {
+      this->blocks = (v != nullptr && v->rank_vector ? &(v->blocks) : nullptr);
+      this->plain_rank.set_vector(v != nullptr ? &(v->plain) : nullptr);
+    }
+    void swap(rank_1_type& another) { this->plain_rank.swap(another.plain_rank); }
+
+    size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const
+    {
+      if(this->blocks == nullptr) { return this->plain_rank.serialize(out, v, name); }
+      sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+      sdsl::structure_tree::add_size(child, 0);
+      return 0;
+    }
+
+    void load(std::istream& in, const FastBitVector* v = nullptr)
+    {
+      this->set_vector(v);
+      if(this->blocks == nullptr) { this->plain_rank.load(in, (v != nullptr ? &(v->plain) : nullptr)); }
+    }
+
+  private:
+    const RankBitVector*        blocks;
+    plain_vector::rank_1_type   plain_rank;
+  };
+
+private:
+  bool          rank_vector;
+  plain_vector  plain;
+  RankBitVector blocks;
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  An alternative encoding for the characters using the fast encoding. The indicator
+  bitvectors for comp values 1 to FAST_CHARS are interleaved into 64-byte blocks, each
+  covering 64 positions. A block starts with the number of occurrences of each comp value
+  before the block, followed by the bits for each comp value. Hence the ranks and the
+  bits for all fast characters at the same position can be found in a single cache line.
+
+  The blocks are stored in a WordBuffer aligned at a 64-byte boundary, which may use
+  huge pages according to HugePages::mode. Alternatively, the blocks can be used directly from a
+  memory-mapped file. The space usage is 8 bits per position, compared to ~4.5 bits
+  per position with four bit_vector_il<512>.
+*/
+
+class PackedBWT
+{
+public:
+  typedef gcsa::size_type size_type;
+
+  constexpr static size_type CHARS       = Alphabet::FAST_CHARS;
+  constexpr static size_type BLOCK_SIZE  = 64;  // Positions per block.
+  constexpr static size_type BLOCK_WORDS = 2 * CHARS;
+  constexpr static size_type ALIGNMENT   = WordBuffer::ALIGNMENT;  // Bytes.
+
+  PackedBWT();
+  PackedBWT(const PackedBWT& source);
+  PackedBWT(PackedBWT&& source);
+  ~PackedBWT();
+
+  // Uses bwt[1] to bwt[fast_chars] as the indicator bitvectors.
+  PackedBWT(const std::vector<sdsl::bit_vector>& bwt, size_type fast_chars);
+
+  void swap(PackedBWT& another);
+  PackedBWT& operator=(const PackedBWT& source);
+  PackedBWT& operator=(PackedBWT&& source);
+
+  // The blocks are aligned at 'alignment' bytes in the file (see serializeWords()).
+  size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "",
+                      size_type position = 0, size_type alignment = ALIGNMENT) const;
+
+  // If mapping is not null, the blocks will be used directly from the mapping.
+  void load(std::istream& in, const MappedFile* mapping = nullptr);
+
+  inline size_type size() const { return this->elements; }
+  inline size_type blocks() const { return this->block_count; }
+
+  // The number of occurrences of comp in [0, i), for 1 <= comp <= CHARS.
+  inline size_type rank(size_type i, comp_type comp) const
+  {
+    const std::uint64_t* block = this->block(i);
+    return block[comp - 1] + sdsl::bits::cnt(block[CHARS + comp - 1] & sdsl::bits::lo_set[i & (BLOCK_SIZE - 1)]);
+  }
+
+  // Stores rank(i, comp) for all fast comp values in results[comp].
+  inline void rank(size_type i, size_type* results) const
+  {
+    const std::uint64_t* block = this->block(i);
+    std::uint64_t mask = sdsl::bits::lo_set[i & (BLOCK_SIZE - 1)];
+    for(size_type comp = 1; comp <= CHARS; comp++)
+    {
+      results[comp] = block[comp - 1] + sdsl::bits::cnt(block[CHARS + comp - 1] & mask);
+    }
+  }
+
+  // Returns the fast comp values at position i as a bitmask, with comp value c at bit c - 1.
+  inline size_type chars(size_type i) const
+  {
+    const std::uint64_t* block = this->block(i);
+    size_type offset = i & (BLOCK_SIZE - 1), res = 0;
+    for(size_type comp = 1; comp <= CHARS; comp++)
+    {
+      res |= ((block[CHARS + comp - 1] >> offset) & 1) << (comp - 1);
+    }
+    return res;
+  }
+
+  inline bool get(size_type i, comp_type comp) const
+  {
+    return (this->block(i)[CHARS + comp - 1] >> (i & (BLOCK_SIZE - 1))) & 1;
+  }
+
+  // Hints that the block containing position i will be needed soon.
+  inline void prefetch(size_type i) const
+  {
+    __builtin_prefetch(this->block(i));
+  }
+
+private:
+  size_type                  elements, block_count;
+  WordBuffer                 data;
+  const std::uint64_t*       first_block; // In data or in a memory-mapped file.
+
+  inline const std::uint64_t* block(size_type i) const
+  {
+    return this->first_block + (i / BLOCK_SIZE) * BLOCK_WORDS;
+  }
+
+  void copy(const PackedBWT& source);
+  std::uint64_t* allocate(size_type n); // Returns the first block.
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  A run-length encoded bitvector for the fast characters in indexes of highly repetitive
+  graphs, where the indicator bitvectors consist of long runs. The space usage depends on
+  the number of runs of 1-bits instead of the length of the bitvector.
+
+  rank() takes one rank and two or three select queries on sd_vector, so queries are
+  slower than with the default encoding. The class can be used as its own rank support.
+*/
+
+class RunLengthVector
+{
+public:
+  typedef gcsa::size_type   size_type;
+  typedef sdsl::sd_vector<> sd_vector;
+
+  RunLengthVector();
+  RunLengthVector(const RunLengthVector& source);
+  RunLengthVector(RunLengthVector&& source);
+  ~RunLengthVector();
+
+  explicit RunLengthVector(const sdsl::bit_vector& source);
+
+  void swap(RunLengthVector& another);
+  RunLengthVector& operator=(const RunLengthVector& source);
+  RunLengthVector& operator=(RunLengthVector&& source);
+
+  size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const;
+  void load(std::istream& in);
+
+  // The first position of each run of 1-bits is marked with an 1-bit.
+  sd_vector                run_starts;
+  sd_vector::rank_1_type   start_rank;
+  sd_vector::select_1_type start_select;
+
+  // Run lengths encoded in unary: k becomes 0^{k-1} 1.
+  sd_vector                run_lengths;
+  sd_vector::select_1_type length_select;
+
+  inline size_type size() const { return this->run_starts.size(); }
+  inline size_type runs() const { return this->start_rank(this->size()); }
+
+  // The number of 1-bits in [0, i).
+  inline size_type rank(size_type i) const
+  {
+    size_type run = this->start_rank(i);
+    if(run == 0) { return 0; }
+    size_type before = this->onesBefore(run);
+    size_type length = this->length_select(run) + 1 - before;
+    return before + std::min(i - this->start_select(run), length);
+  }
+
+  inline size_type operator()(size_type i) const { return this->rank(i); }
+
+  inline bool operator[](size_type i) const
+  {
+    size_type run = this->start_rank(i + 1);
+    if(run == 0) { return false; }
+    size_type before = this->onesBefore(run);
+    return (i <= this->start_select(run) + (this->length_select(run) - before));
+  }
+
+private:
+  // The number of 1-bits in the runs before the given run (1-based).
+  inline size_type onesBefore(size_type run) const
+  {
+    return (run > 1 ? this->length_select(run - 1) + 1 : 0);
+  }
+
+  void copy(const RunLengthVector& source);
+  void setVectors();
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  An alternative encoding for the characters using the sparse encoding, including the
+  endmarker (comp value 0). Positions with at least one sparse character are marked in
+  a filter. The indicator bits of all sparse characters are stored for the marked
+  positions in blocks of 64 entries. Each block starts with the number of occurrences
+  of each character before the block, as in PackedBWT.
+
+  A single filter rank and a single block access give all sparse characters at a
+  position and their ranks. The default encoding needs a separate sd_vector query for
+  each sparse character.
+
+  The blocks can be used directly from a memory-mapped file, while the filter is always
+  loaded into memory.
+*/
+
+class SparseBWT
+{
+public:
+  typedef gcsa::size_type   size_type;
+  typedef sdsl::sd_vector<> sd_vector;
+
+  constexpr static size_type BLOCK_SIZE = 64; // Entries per block.
+  constexpr static size_type ALIGNMENT  = WordBuffer::ALIGNMENT;  // Bytes.
+
+  SparseBWT();
+  SparseBWT(const SparseBWT& source);
+  SparseBWT(SparseBWT&& source);
+  ~SparseBWT();
+
+  // Uses bwt[0] and bwt[fast_chars + 1] to bwt[bwt.size() - 1] as the indicator bitvectors.
+  SparseBWT(const std::vector<sdsl::bit_vector>& bwt, size_type fast_chars);
+
+  void swap(SparseBWT& another);
+  SparseBWT& operator=(const SparseBWT& source);
+  SparseBWT& operator=(SparseBWT&& source);
+
+  // The blocks are aligned at 'alignment' bytes in the file (see serializeWords()).
+  size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "",
+                      size_type position = 0, size_type alignment = ALIGNMENT) const;
+
+  // If mapping is not null, the blocks will be used directly from the mapping.
+  void load(std::istream& in, const MappedFile* mapping = nullptr);
+
+  inline size_type size() const { return this->filter.size(); }
+  inline size_type entries() const { return this->filter_rank(this->size()); }
+  inline size_type charCount() const { return this->char_count; }
+
+  // Character index j in the blocks corresponds to comp value charComp(j).
+  inline size_type charIndex(comp_type comp) const { return (comp == 0 ? 0 : comp - this->fast_chars); }
+  inline comp_type charComp(size_type j) const { return (j == 0 ? 0 : j + this->fast_chars); }
+
+  // The number of occurrences of sparse comp in [0, i).
+  inline size_type rank(size_type i, comp_type comp) const
+  {
+    return this->entryRank(this->filter_rank(i), this->charIndex(comp));
+  }
+
+  // Stores rank(i, charComp(j)) in results[j] for all sparse characters.
+  inline void rank(size_type i, size_type* results) const
+  {
+    size_type entry = this->filter_rank(i);
+    const std::uint64_t* block = this->block(entry);
+    std::uint64_t mask = sdsl::bits::lo_set[entry & (BLOCK_SIZE - 1)];
+    for(size_type j = 0; j < this->char_count; j++)
+    {
+      results[j] = block[j] + sdsl::bits::cnt(block[this->char_count + j] & mask);
+    }
+  }
+
+  /*
+    Returns the first sparse comp value at position i in order fast_chars + 1, ...,
+    fast_chars + charCount() - 1, 0, and stores rank(i, comp) in rank. Returns 0 if
+    there are no sparse characters at the position.
+  */
+  inline comp_type first(size_type i, size_type& rank) const
+  {
+    size_type entry = this->filter_rank(i);
+    if(this->filter[i])
+    {
+      const std::uint64_t* block = this->block(entry);
+      size_type offset = entry & (BLOCK_SIZE - 1);
+      for(size_type k = 1; k <= this->char_count; k++)
+      {
+        size_type j = k % this->char_count;
+        if((block[this->char_count + j] >> offset) & 1)
+        {
+          rank = block[j] + sdsl::bits::cnt(block[this->char_count + j] & sdsl::bits::lo_set[offset]);
+          return this->charComp(j);
+        }
+      }
+    }
+    rank = this->entryRank(entry, 0);
+    return 0;
+  }
+
+private:
+  size_type              fast_chars, char_count;
+
+  // Positions with sparse characters are marked with an 1-bit.
+  sd_vector              filter;
+  sd_vector::rank_1_type filter_rank;
+
+  // Blocks of 2 * char_count words: the ranks before the block and the indicator bits.
+  size_type              block_count;
+  WordBuffer             data;
+  const std::uint64_t*   first_block; // In data or in a memory-mapped file.
+
+  inline const std::uint64_t* block(size_type entry) const
+  {
+    return this->first_block + (entry / BLOCK_SIZE) * 2 * this->char_count;
+  }
+
+  inline size_type entryRank(size_type entry, size_type j) const
+  {
+    const std::uint64_t* block = this->block(entry);
+    return block[j] + sdsl::bits::cnt(block[this->char_count + j] & sdsl::bits::lo_set[entry & (BLOCK_SIZE - 1)]);
+  }
+
+  void copy(const SparseBWT& source);
+  void setVectors();
+  std::uint64_t* allocate(size_type blocks); // Returns the first block.
+};
+
+//------------------------------------------------------------------------------
+
 /*
   This interface is intended for indexing kmers of length 16 or less on an alphabet of size
   8 or less. The kmer is encoded as an 64-bit integer (most significant bit first):
@@ -377,9 +906,15 @@ struct Key
 
   static key_type encode(const Alphabet& alpha, const std::string& kmer,
     byte_type pred, byte_type succ)
+  {
+    return encode(alpha, kmer.data(), kmer.length(), pred, succ);
+  }
+
+  static key_type encode(const Alphabet& alpha, const char* kmer, size_type kmer_length,
+    byte_type pred, byte_type succ)
   {
     key_type value = 0;
-    for(size_type i = 0; i < kmer.length(); i++)
+    for(size_type i = 0; i < kmer_length; i++)
     {
       value = (value << GCSA_CHAR_WIDTH) | alpha.char2comp[kmer[i]];
     }
@@ -453,6 +988,7 @@ struct Node
   }
 
   static node_type encode(const std::string& token);
+  static node_type encode(const char* token_begin, const char* token_end);  // Parses the token in place.
   static std::string decode(node_type node);
 
   static size_type id(node_type node) { return node >> ID_OFFSET; }
@@ -487,6 +1023,7 @@ struct KMer
   void makeSorted() { this->to = ~(node_type)0; }
 
   static byte_type chars(const std::string& token, const Alphabet& alpha);
+  static byte_type chars(const char* token_begin, const char* token_end, const Alphabet& alpha);
 };
 
 std::ostream& operator<< (std::ostream& out, const KMer& kmer);
@@ -31,6 +31,8 @@
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include <sdsl/wavelet_trees.hpp>
@@ -154,11 +156,11 @@ struct Version
   static void print(std::ostream& out, const std::string& tool_name, bool verbose = false, size_type new_lines = 2);
 
   constexpr static size_type MAJOR_VERSION = 1;
-  constexpr static size_type MINOR_VERSION = 2;
+  constexpr static size_type MINOR_VERSION = 3;
   constexpr static size_type PATCH_VERSION = 0;
 
-  constexpr static size_type GCSA_VERSION  = 3;
-  constexpr static size_type LCP_VERSION   = 1;
+  constexpr static size_type GCSA_VERSION  = 5;
+  constexpr static size_type LCP_VERSION   = 2;
 };
 
 //------------------------------------------------------------------------------
@@ -242,6 +244,11 @@ size_type writeVolume();  // Only for GCSA construction.
   remaining temporary files are deleted when the program exits (normally or
   with std::exit()).
 
+  If drop_cache is set, ReadBuffer and WriteBuffer drop the files they have used from
+  the page cache (on Linux). This keeps large construction data from evicting other
+  data, but small files that would otherwise be deleted before writeback are then
+  written to disk.
+
   TempFile is not thread-safe!
 */
 
@@ -249,6 +256,7 @@ namespace TempFile
 {
   extern const std::string DEFAULT_TEMP_DIR;
   extern std::string temp_dir;
+  extern bool drop_cache;
 
   void setDirectory(const std::string& directory);
   std::string getName(const std::string& name_part);
@@ -263,6 +271,249 @@ size_type fileSize(std::ofstream& file);
 
 //------------------------------------------------------------------------------
 
+/*
+  A read-only memory-mapped file. The mapping is shared, so multiple processes
+  mapping the same file use the same copy in the page cache.
+*/
+
+class MappedFile
+{
+public:
+  MappedFile();
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  bool open(const std::string& filename);
+  void close();
+
+  inline bool isOpen() const { return (this->base != nullptr); }
+  inline const char* data() const { return this->base; }
+  inline size_type size() const { return this->bytes; }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator= (const MappedFile&) = delete;
+
+private:
+  const char* base;
+  size_type   bytes;
+};
+
+/*
+  A stream buffer for loading structures from a MappedFile using the normal
+  load() interface. Supports seeking, so that the structures can determine
+  their position in the mapping.
+*/
+
+class MappedStreamBuffer : public std::streambuf
+{
+public:
+  explicit MappedStreamBuffer(const MappedFile& file);
+
+protected:
+  pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+/*
+  Aligned arrays of 64-bit words. The array is stored as the number of words, the
+  number of padding bytes, the padding, and the words. The padding is chosen so that
+  the words start at a multiple of 'alignment' bytes from the beginning of the file.
+  The offset is taken from out.tellp(). If the stream cannot report its position,
+  serializeWords() assumes that the enclosing structure starts at the beginning of the
+  file and 'position' bytes of it have already been written.
+
+  loadWords() reads the words into the buffer. If the stream is over the given
+  mapping, mapWords() returns a pointer to the words in the mapping instead. If the
+  words are not aligned at a word boundary in the file, mapWords() returns nullptr
+  without consuming them, and the caller should use loadWords().
+*/
+
+constexpr size_type MAPPED_ALIGNMENT = 4096;
+
+size_type serializeWords(const std::uint64_t* data, size_type words, std::ostream& out, size_type position,
+                         sdsl::structure_tree_node* v = nullptr, std::string name = "",
+                         size_type alignment = MAPPED_ALIGNMENT);
+size_type loadWordCount(std::istream& in);  // Also skips the padding.
+void loadWords(std::istream& in, std::uint64_t* buffer, size_type words);
+const std::uint64_t* mapWords(std::istream& in, const MappedFile& mapping, size_type words);
+
+/*
+  A read-only view of an array with the same layout as sdsl::int_vector<0>. The
+  data is owned by an int_vector or a MappedFile.
+*/
+
+class IntVectorView
+{
+public:
+  IntVectorView() : words(nullptr), elements(0), bits(1) {}
+
+  IntVectorView(const std::uint64_t* data, size_type n, size_type width) :
+    words(data), elements(n), bits(width)
+  {
+  }
+
+  template<std::uint8_t WIDTH>
+  explicit IntVectorView(const sdsl::int_vector<WIDTH>& source) :
+    words(source.data()), elements(source.size()), bits(source.width())
+  {
+  }
+
+  inline size_type size() const { return this->elements; }
+  inline size_type width() const { return this->bits; }
+  inline const std::uint64_t* data() const { return this->words; }
+
+  inline size_type operator[] (size_type i) const
+  {
+    size_type bit = i * this->bits, word = bit / WORD_BITS, offset = bit % WORD_BITS;
+    std::uint64_t res = this->words[word] >> offset;
+    if(offset + this->bits > WORD_BITS) { res |= this->words[word + 1] << (WORD_BITS - offset); }
+    return res & sdsl::bits::lo_set[this->bits];
+  }
+
+private:
+  const std::uint64_t* words;
+  size_type            elements, bits;
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  Page placement for the large arrays used in queries. The mode applies to WordBuffer
+  allocations made after setting it, so it should be set before loading the index.
+
+  NORMAL       ordinary pages from the heap
+  TRANSPARENT  2 MB aligned anonymous mappings with madvise(MADV_HUGEPAGE)
+  EXPLICIT     MAP_HUGETLB from the preallocated huge page pool; falls back to
+               TRANSPARENT if the pool is too small
+
+  Buffers smaller than PAGE_SIZE always use ordinary pages. advise() asks for
+  transparent huge pages for memory that was not allocated through WordBuffer.
+  The modes other than NORMAL are only effective on Linux.
+*/
+
+struct HugePages
+{
+  enum mode_type { NORMAL, TRANSPARENT, EXPLICIT };
+
+  static mode_type mode;
+
+  static void set(mode_type new_mode);
+  static std::string modeName();
+
+  static void advise(const void* data, size_type bytes);
+
+  constexpr static size_type PAGE_SIZE = 2 * MEGABYTE;
+};
+
+/*
+  A zero-initialized array of 64-bit words allocated according to HugePages::mode.
+  The array is aligned at ALIGNMENT bytes, or at HugePages::PAGE_SIZE bytes if it is
+  backed by huge pages.
+*/
+
+class WordBuffer
+{
+public:
+  WordBuffer();
+  explicit WordBuffer(size_type n);
+  WordBuffer(WordBuffer&& source);
+  ~WordBuffer();
+
+  void swap(WordBuffer& another);
+  WordBuffer& operator=(WordBuffer&& source);
+
+  inline size_type size() const { return this->words; }
+  inline std::uint64_t* data() { return this->buffer; }
+  inline const std::uint64_t* data() const { return this->buffer; }
+
+  // Is the buffer a separate mapping that may use huge pages?
+  inline bool mapped() const { return (this->mapped_bytes > 0); }
+
+  constexpr static size_type ALIGNMENT = 64;  // Bytes.
+
+  WordBuffer(const WordBuffer&) = delete;
+  WordBuffer& operator= (const WordBuffer&) = delete;
+
+private:
+  std::uint64_t* buffer;
+  size_type      words, mapped_bytes;
+
+  void release();
+};
+
+//------------------------------------------------------------------------------
+
+/*
+  NUMA topology from /sys/devices/system/node. The nodes with CPUs are numbered
+  0 to nodes() - 1 in the order of their system identifiers. Without NUMA support,
+  there is a single node containing all CPUs.
+
+  bindThread() restricts the calling thread to the CPUs of the given node and
+  returns false on failure. Memory allocated by a bound thread is placed on the
+  local node under the default first-touch policy.
+*/
+
+namespace NUMA
+{
+  size_type nodes();
+  size_type currentNode();  // The node of the CPU running the calling thread.
+  bool bindThread(size_type node);
+}
+
+/*
+  Read-only copies of a structure on each NUMA node. Each copy is made by a thread
+  bound to the node, so its memory is local to the node. local() returns the copy
+  for the node the calling thread is currently running on. Worker threads that
+  should always use the same copy can be pinned with NUMA::bindThread().
+
+  With a single node, the replicas refer to the source, which must outlive them.
+  Otherwise the source is no longer needed after construction. Any memory-mapped
+  parts of the source are shared between the copies.
+*/
+
+template<class Structure>
+class NUMAReplicas
+{
+public:
+  NUMAReplicas() {}
+
+  explicit NUMAReplicas(const Structure& source)
+  {
+    size_type n = NUMA::nodes();
+    if(n <= 1) { this->replicas.push_back(&source); return; }
+
+    this->copies.resize(n);
+    std::vector<std::thread> threads;
+    for(size_type node = 0; node < n; node++)
+    {
+      threads.emplace_back([this, &source, node]()
+      {
+        NUMA::bindThread(node);
+        this->copies[node].reset(new Structure(source));
+      });
+    }
+    for(std::thread& thread : threads) { thread.join(); }
+    for(auto& copy : this->copies) { this->replicas.push_back(copy.get()); }
+  }
+
+  inline size_type size() const { return this->replicas.size(); }
+  inline const Structure& operator[](size_type node) const { return *(this->replicas[node]); }
+
+  inline const Structure& local() const
+  {
+    return *(this->replicas[NUMA::currentNode() % this->size()]);
+  }
+
+  NUMAReplicas(const NUMAReplicas&) = delete;
+  NUMAReplicas& operator= (const NUMAReplicas&) = delete;
+
+private:
+  std::vector<std::unique_ptr<Structure>> copies;
+  std::vector<const Structure*>           replicas;
+};
+
+//------------------------------------------------------------------------------
+
 /*
   parallelQuickSort() uses less working space than parallelMergeSort(). Calling omp_set_nested(1)
   improves the speed of parallelQuickSort().
@@ -25,6 +25,9 @@
 
 #include <gcsa/internal.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace gcsa
 {
 
@@ -33,9 +36,10 @@ namespace gcsa
 // Numerical class constants.
 
 constexpr size_type DiskIO::block_size;
+constexpr size_type BlockIndex::BLOCK_SIZE;
 
 template<class Element> constexpr size_type ReadBuffer<Element>::READ_BUFFER_SIZE;
-template<class Element> constexpr size_type ReadBuffer<Element>::MINIMUM_SIZE;
+template<class Element> constexpr size_type WriteBuffer<Element>::WRITE_QUEUE_SIZE;
 
 //------------------------------------------------------------------------------
 
@@ -46,6 +50,180 @@ std::atomic<size_type> DiskIO::write_volume(0);
 
 //------------------------------------------------------------------------------
 
+PageCache::PageCache() :
+  fd(-1)
+{
+}
+
+PageCache::~PageCache()
+{
+  this->close();
+}
+
+void
+PageCache::open(const std::string& filename)
+{
+  this->close();
+#if defined(POSIX_FADV_WILLNEED) && defined(SYNC_FILE_RANGE_WRITE)
+  this->fd = ::open(filename.c_str(), O_RDONLY);
+#endif
+}
+
+void
+PageCache::close()
+{
+  if(this->fd >= 0) { ::close(this->fd); this->fd = -1; }
+}
+
+void
+PageCache::prefetch(size_type offset, size_type bytes) const
+{
+#ifdef POSIX_FADV_WILLNEED
+  if(this->fd < 0 || bytes == 0) { return; }
+  posix_fadvise(this->fd, offset, bytes, POSIX_FADV_WILLNEED);
+#endif
+}
+
+void
+PageCache::release(size_type offset, size_type bytes) const
+{
+#ifdef POSIX_FADV_DONTNEED
+  if(this->fd < 0 || bytes == 0 || !(TempFile::drop_cache)) { return; }
+  posix_fadvise(this->fd, offset, bytes, POSIX_FADV_DONTNEED);
+#endif
+}
+
+void
+PageCache::writeBack(size_type offset, size_type bytes) const
+{
+#ifdef SYNC_FILE_RANGE_WRITE
+  if(this->fd < 0 || bytes == 0 || !(TempFile::drop_cache)) { return; }
+  sync_file_range(this->fd, offset, bytes, SYNC_FILE_RANGE_WRITE);
+#endif
+}
+
+void
+PageCache::releaseWritten(size_type offset, size_type bytes) const
+{
+#ifdef SYNC_FILE_RANGE_WRITE
+  if(this->fd < 0 || bytes == 0 || !(TempFile::drop_cache)) { return; }
+  sync_file_range(this->fd, offset, bytes, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+  this->release(offset, bytes);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+BlockIndex::BlockIndex() :
+  offsets(1, 0), starts(1, 0)
+{
+}
+
+void
+BlockIndex::clear()
+{
+  this->offsets.resize(1); this->offsets[0] = 0;
+  this->starts.resize(1); this->starts[0] = 0;
+}
+
+size_type
+BlockIndex::find(size_type i) const
+{
+  return std::upper_bound(this->starts.begin(), this->starts.end(), i) - this->starts.begin() - 1;
+}
+
+void
+BlockIndex::add(size_type block_bytes, size_type block_elements)
+{
+  this->offsets.push_back(this->bytes() + block_bytes);
+  this->starts.push_back(this->elements() + block_elements);
+}
+
+void
+BlockIndex::write(std::ostream& out) const
+{
+  DiskIO::write(out, this->offsets.data(), this->offsets.size());
+  DiskIO::write(out, this->starts.data(), this->starts.size());
+  size_type block_count = this->blocks();
+  DiskIO::write(out, &block_count);
+}
+
+bool
+BlockIndex::read(std::istream& in)
+{
+  this->clear();
+
+  // The number of blocks is the last word of the file.
+  in.seekg(0, std::ios_base::end);
+  size_type file_size = in.tellg();
+  if(file_size < sizeof(size_type)) { return false; }
+  size_type block_count = 0;
+  in.seekg(file_size - sizeof(size_type), std::ios_base::beg);
+  if(!DiskIO::read(in, &block_count)) { return false; }
+
+  size_type index_size = (2 * (block_count + 1) + 1) * sizeof(size_type);
+  if(index_size > file_size) { return false; }
+  this->offsets.resize(block_count + 1); this->starts.resize(block_count + 1);
+  in.seekg(file_size - index_size, std::ios_base::beg);
+  if(!DiskIO::read(in, this->offsets.data(), this->offsets.size())) { return false; }
+  if(!DiskIO::read(in, this->starts.data(), this->starts.size())) { return false; }
+
+  return (this->bytes() + index_size == file_size);
+}
+
+//------------------------------------------------------------------------------
+
+void
+BlockCodec<std::uint32_t>::encode(const std::uint32_t* data, size_type n, std::vector<byte_type>& output)
+{
+  if(n == 0) { return; }
+
+  std::uint32_t low = *std::min_element(data, data + n), high = *std::max_element(data, data + n);
+  size_type width = bit_length(high - low);
+  ByteCode::write(output, low);
+  output.push_back(width);
+
+  size_type buffer = 0, bits = 0;
+  for(size_type i = 0; i < n; i++)
+  {
+    buffer |= (size_type)(data[i] - low) << bits; bits += width;
+    while(bits >= BYTE_BITS)
+    {
+      output.push_back(buffer & 0xFF);
+      buffer >>= BYTE_BITS; bits -= BYTE_BITS;
+    }
+  }
+  if(bits > 0) { output.push_back(buffer); }
+}
+
+bool
+BlockCodec<std::uint32_t>::decode(const std::vector<byte_type>& input, std::uint32_t* data, size_type n)
+{
+  if(n == 0) { return input.empty(); }
+
+  size_type i = 0;
+  std::uint32_t low = ByteCode::read(input, i);
+  if(i >= input.size()) { return false; }
+  size_type width = input[i]; i++;
+  if(width > 32 || input.size() - i != (n * width + BYTE_BITS - 1) / BYTE_BITS) { return false; }
+
+  size_type buffer = 0, bits = 0, mask = sdsl::bits::lo_set[width];
+  for(size_type j = 0; j < n; j++)
+  {
+    while(bits < width)
+    {
+      buffer |= (size_type)input[i] << bits; i++;
+      bits += BYTE_BITS;
+    }
+    data[j] = low + (buffer & mask);
+    buffer >>= width; bits -= width;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
 CounterArray::CounterArray() :
   width(8), large_value(sdsl::bits::lo_set[width]),
   total(0)
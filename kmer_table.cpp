@@ -0,0 +1,199 @@
+/*
+  Copyright (c) 2019 Jouni Sirén
+
+  Author: Jouni Siren <jouni.siren@iki.fi>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <gcsa/kmer_table.h>
+
+#include <gcsa/internal.h>
+
+namespace gcsa
+{
+
+//------------------------------------------------------------------------------
+
+// Numerical class constants.
+
+constexpr uint32_t KMerTable::TAG;
+constexpr uint32_t KMerTable::VERSION;
+constexpr size_type KMerTable::DEFAULT_LENGTH;
+constexpr size_type KMerTable::MAX_ENTRIES;
+
+//------------------------------------------------------------------------------
+
+// Other class variables.
+
+const std::string KMerTable::EXTENSION = ".ktab";
+
+//------------------------------------------------------------------------------
+
+KMerTable::KMerTable() :
+  kmer_length(0), fast_chars(0)
+{
+}
+
+KMerTable::KMerTable(const KMerTable& source)
+{
+  this->copy(source);
+}
+
+KMerTable::KMerTable(KMerTable&& source)
+{
+  *this = std::move(source);
+}
+
+KMerTable::~KMerTable()
+{
+}
+
+void
+KMerTable::copy(const KMerTable& source)
+{
+  this->kmer_length = source.kmer_length;
+  this->fast_chars = source.fast_chars;
+  this->starts = source.starts;
+  this->limits = source.limits;
+}
+
+void
+KMerTable::swap(KMerTable& another)
+{
+  if(this != &another)
+  {
+    std::swap(this->kmer_length, another.kmer_length);
+    std::swap(this->fast_chars, another.fast_chars);
+    this->starts.swap(another.starts);
+    this->limits.swap(another.limits);
+  }
+}
+
+KMerTable&
+KMerTable::operator=(const KMerTable& source)
+{
+  if(this != &source) { this->copy(source); }
+  return *this;
+}
+
+KMerTable&
+KMerTable::operator=(KMerTable&& source)
+{
+  if(this != &source)
+  {
+    this->kmer_length = source.kmer_length;
+    this->fast_chars = source.fast_chars;
+    this->starts = std::move(source.starts);
+    this->limits = std::move(source.limits);
+  }
+  return *this;
+}
+
+KMerTable::size_type
+KMerTable::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string name) const
+{
+  sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+  size_type written_bytes = 0;
+
+  written_bytes += sdsl::write_member(TAG, out, child, "tag");
+  written_bytes += sdsl::write_member(VERSION, out, child, "version");
+  written_bytes += sdsl::write_member(this->kmer_length, out, child, "kmer_length");
+  written_bytes += sdsl::write_member(this->fast_chars, out, child, "fast_chars");
+  written_bytes += this->starts.serialize(out, child, "starts");
+  written_bytes += this->limits.serialize(out, child, "limits");
+
+  sdsl::structure_tree::add_size(child, written_bytes);
+  return written_bytes;
+}
+
+void
+KMerTable::load(std::istream& in)
+{
+  uint32_t tag = 0, version = 0;
+  sdsl::read_member(tag, in);
+  sdsl::read_member(version, in);
+  if(tag != TAG || version != VERSION)
+  {
+    std::cerr << "KMerTable::load(): Invalid header: tag " << tag << ", version " << version << std::endl;
+  }
+
+  sdsl::read_member(this->kmer_length, in);
+  sdsl::read_member(this->fast_chars, in);
+  this->starts.load(in);
+  this->limits.load(in);
+}
+
+//------------------------------------------------------------------------------
+
+KMerTable::KMerTable(const GCSA& index, size_type length) :
+  kmer_length(0), fast_chars(index.alpha.fast_chars)
+{
+  if(index.empty() || this->fast_chars == 0) { return; }
+
+  // Determine the kmer length.
+  size_type entries = this->fast_chars;
+  this->kmer_length = 1;
+  while(this->kmer_length < length && entries * this->fast_chars <= MAX_ENTRIES)
+  {
+    this->kmer_length++; entries *= this->fast_chars;
+  }
+  if(this->kmer_length < length && Verbosity::level >= Verbosity::BASIC)
+  {
+    std::cerr << "KMerTable::KMerTable(): Using kmer length " << this->kmer_length << " instead of " << length << std::endl;
+  }
+
+  // Extend the kmers backwards one character at a time. The ranges for the current suffix
+  // length are stored in curr, and the first character is the most significant digit.
+  std::vector<range_type> curr(this->fast_chars), next;
+  for(size_type i = 0; i < this->fast_chars; i++) { curr[i] = index.charRange(i + 1); }
+  for(size_type level = 1; level < this->kmer_length; level++)
+  {
+    next.resize(curr.size() * this->fast_chars);
+    #pragma omp parallel for schedule(static)
+    for(size_type i = 0; i < curr.size(); i++)
+    {
+      for(size_type c = 0; c < this->fast_chars; c++)
+      {
+        next[c * curr.size() + i] = (Range::empty(curr[i]) ? Range::empty_range() : index.LF(curr[i], c + 1));
+      }
+    }
+    curr.swap(next);
+  }
+  sdsl::util::clear(next);
+
+  size_type width = bit_length(index.size());
+  this->starts = sdsl::int_vector<0>(curr.size(), 0, width);
+  this->limits = sdsl::int_vector<0>(curr.size(), 0, width);
+  for(size_type i = 0; i < curr.size(); i++)
+  {
+    if(Range::empty(curr[i])) { continue; }
+    this->starts[i] = curr[i].first;
+    this->limits[i] = curr[i].second + 1;
+  }
+
+  if(Verbosity::level >= Verbosity::EXTENDED)
+  {
+    std::cerr << "KMerTable::KMerTable(): " << this->size() << " entries for kmer length " << this->length() << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace gcsa
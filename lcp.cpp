@@ -29,6 +29,11 @@
 
 #include <gcsa/internal.h>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define GCSA_X86_KERNELS
+#endif
+
 namespace gcsa
 {
 
@@ -37,6 +42,7 @@ namespace gcsa
 // Numerical class constants.
 
 constexpr size_type STNode::UNKNOWN;
+constexpr size_type LCPArray::LEVEL_ALIGNMENT;
 
 //------------------------------------------------------------------------------
 
@@ -79,7 +85,10 @@ LCPArray::copy(const LCPArray& source)
 {
   this->header = source.header;
   this->data = source.data;
+  this->lcp_values = source.lcp_values;
   this->offsets = source.offsets;
+  this->mapping = source.mapping;
+  this->setVectors();
 }
 
 void
@@ -89,7 +98,9 @@ LCPArray::swap(LCPArray& another)
   {
     this->header.swap(another.header);
     this->data.swap(another.data);
+    std::swap(this->lcp_values, another.lcp_values);
     this->offsets.swap(another.offsets);
+    this->mapping.swap(another.mapping);
   }
 }
 
@@ -107,7 +118,10 @@ LCPArray::operator=(LCPArray&& source)
   {
     this->header = std::move(source.header);
     this->data = std::move(source.data);
+    this->lcp_values = source.lcp_values;
     this->offsets = std::move(source.offsets);
+    this->mapping = std::move(source.mapping);
+    this->setVectors();
   }
   return *this;
 }
@@ -119,7 +133,23 @@ LCPArray::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string
   size_type written_bytes = 0;
 
   written_bytes += this->header.serialize(out, child, "header");
-  written_bytes += this->data.serialize(out, child, "data");
+  if(this->header.get(LCPHeader::MAPPABLE))
+  {
+    sdsl::structure_tree_node* data_node =
+      sdsl::structure_tree::add_child(child, "data", "mappable_int_vector");
+    size_type data_bytes = 0;
+    size_type count = this->lcp_values.size(), width = this->lcp_values.width();
+    data_bytes += sdsl::write_member(count, out, data_node, "size");
+    data_bytes += sdsl::write_member(width, out, data_node, "width");
+    data_bytes += serializeWords(this->lcp_values.data(), (count * width + WORD_BITS - 1) / WORD_BITS, out,
+                                 written_bytes + data_bytes, data_node, "data");
+    sdsl::structure_tree::add_size(data_node, data_bytes);
+    written_bytes += data_bytes;
+  }
+  else
+  {
+    written_bytes += this->data.serialize(out, child, "data");
+  }
   written_bytes += this->offsets.serialize(out, child, "offsets");
 
   sdsl::structure_tree::add_size(child, written_bytes);
@@ -128,6 +158,35 @@ LCPArray::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string
 
 void
 LCPArray::load(std::istream& in)
+{
+  this->mapping.reset();
+  this->load(in, nullptr);
+}
+
+bool
+LCPArray::map(const std::string& filename)
+{
+  std::shared_ptr<MappedFile> file(new MappedFile(filename));
+  if(!(file->isOpen())) { return false; }
+
+  MappedStreamBuffer buffer(*file);
+  std::istream in(&buffer);
+  this->mapping = file;
+  this->load(in, file.get());
+  if(!in)
+  {
+    std::cerr << "LCPArray::map(): Unexpected end of file in " << filename << std::endl;
+    *this = LCPArray();
+    return false;
+  }
+
+  // Release the mapping if the values were converted or copied.
+  if(!(this->header.get(LCPHeader::MAPPABLE)) || !(this->data.empty())) { this->mapping.reset(); }
+  return true;
+}
+
+void
+LCPArray::load(std::istream& in, const MappedFile* file)
 {
   this->header.load(in);
   if(!(this->header.check()))
@@ -135,8 +194,57 @@ LCPArray::load(std::istream& in)
     std::cerr << "LCP::load(): Invalid header: " << this->header << std::endl;
   }
 
-  this->data.load(in);
+  if(this->header.get(LCPHeader::MAPPABLE))
+  {
+    size_type count = 0, width = 0;
+    sdsl::read_member(count, in);
+    sdsl::read_member(width, in);
+    size_type words = loadWordCount(in);
+    const std::uint64_t* mapped = (file != nullptr ? mapWords(in, *file, words) : nullptr);
+    if(mapped != nullptr)
+    {
+      sdsl::util::clear(this->data);
+      this->lcp_values = IntVectorView(mapped, count, width);
+    }
+    else
+    {
+      this->data = sdsl::int_vector<0>(count, 0, width);
+      loadWords(in, this->data.data(), words);
+      this->lcp_values = IntVectorView(this->data);
+    }
+  }
+  else
+  {
+    this->data.load(in);
+    this->lcp_values = IntVectorView(this->data);
+  }
   this->offsets.load(in);
+  if(this->header.version < LCPHeader::VERSION) { this->upgrade(); }
+  this->setLevelEnds();
+}
+
+void
+LCPArray::setVectors()
+{
+  if(!(this->mapping != nullptr && this->header.get(LCPHeader::MAPPABLE)))
+  {
+    this->lcp_values = IntVectorView(this->data);
+  }
+  this->setLevelEnds();
+}
+
+void
+LCPArray::setLevelEnds()
+{
+  this->level_ends.clear();
+  if(this->offsets.size() == 0) { return; }
+
+  size_type level_size = this->size();
+  for(size_type level = 0; level < this->levels(); level++)
+  {
+    this->level_ends.push_back(this->offsets[level] + level_size);
+    level_size = (level_size + this->branching() - 1) / this->branching();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -173,7 +281,7 @@ rmtFirstSibling(const LCPArray& lcp, size_type node, size_type level)
 inline size_type
 rmtLastSibling(const LCPArray& lcp, size_type first_child, size_type level)
 {
-  return std::min(lcp.offsets[level + 1], first_child + lcp.branching()) - 1;
+  return std::min(lcp.level_ends[level], first_child + lcp.branching()) - 1;
 }
 
 inline size_type
@@ -198,6 +306,379 @@ rmtLevel(const LCPArray& lcp, size_type node)
 
 //------------------------------------------------------------------------------
 
+/*
+  Scans over the children of a range minimum tree node. With 8-bit and 16-bit values,
+  the scans compare 16 or 32 bytes at once using SSE2 or AVX2 and find the position in
+  the movemask with a bit scan. AVX2 is selected at run time. Each kernel returns n if
+  there is no suitable position.
+*/
+
+template<class Element>
+struct ScanKernels
+{
+  size_type (*first_at_most)(const Element* values, size_type n, Element limit);
+  size_type (*last_at_most)(const Element* values, size_type n, Element limit);
+  Element (*minimum)(const Element* values, size_type n);
+};
+
+template<class Element>
+size_type
+firstAtMostPortable(const Element* values, size_type n, Element limit)
+{
+  for(size_type i = 0; i < n; i++)
+  {
+    if(values[i] <= limit) { return i; }
+  }
+  return n;
+}
+
+template<class Element>
+size_type
+lastAtMostPortable(const Element* values, size_type n, Element limit)
+{
+  for(size_type i = n; i > 0; i--)
+  {
+    if(values[i - 1] <= limit) { return i - 1; }
+  }
+  return n;
+}
+
+template<class Element>
+Element
+minimumPortable(const Element* values, size_type n)
+{
+  Element res = ~(Element)0;
+  for(size_type i = 0; i < n; i++) { res = std::min(res, values[i]); }
+  return res;
+}
+
+#ifdef GCSA_X86_KERNELS
+
+/*
+  SSE2 operations on unsigned lanes. SSE2 has no unsigned 16-bit minimum, so we flip
+  the sign bits and use the signed one. The masks have one bit per byte.
+*/
+
+inline __m128i splat(std::uint8_t value) { return _mm_set1_epi8(value); }
+inline __m128i splat(std::uint16_t value) { return _mm_set1_epi16(value); }
+
+inline __m128i
+lanesMin(__m128i a, __m128i b, std::uint8_t)
+{
+  return _mm_min_epu8(a, b);
+}
+
+inline __m128i
+lanesMin(__m128i a, __m128i b, std::uint16_t)
+{
+  const __m128i flip = _mm_set1_epi16(-0x8000);
+  return _mm_xor_si128(_mm_min_epi16(_mm_xor_si128(a, flip), _mm_xor_si128(b, flip)), flip);
+}
+
+inline std::uint32_t
+atMostMask(__m128i values, __m128i limit, std::uint8_t tag)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(lanesMin(values, limit, tag), values));
+}
+
+inline std::uint32_t
+atMostMask(__m128i values, __m128i limit, std::uint16_t tag)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi16(lanesMin(values, limit, tag), values));
+}
+
+template<class Element>
+size_type
+firstAtMostSSE2(const Element* values, size_type n, Element limit)
+{
+  constexpr size_type LANES = sizeof(__m128i) / sizeof(Element);
+  __m128i lim = splat(limit);
+  size_type i = 0;
+  for(; i + LANES <= n; i += LANES)
+  {
+    std::uint32_t mask = atMostMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), lim, limit);
+    if(mask != 0) { return i + __builtin_ctz(mask) / sizeof(Element); }
+  }
+  return i + firstAtMostPortable(values + i, n - i, limit);
+}
+
+template<class Element>
+size_type
+lastAtMostSSE2(const Element* values, size_type n, Element limit)
+{
+  constexpr size_type LANES = sizeof(__m128i) / sizeof(Element);
+  __m128i lim = splat(limit);
+  size_type i = n;
+  for(; i >= LANES; i -= LANES)
+  {
+    std::uint32_t mask = atMostMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i - LANES)), lim, limit);
+    if(mask != 0) { return i - LANES + (31 - __builtin_clz(mask)) / sizeof(Element); }
+  }
+  size_type res = lastAtMostPortable(values, i, limit);
+  return (res < i ? res : n);
+}
+
+template<class Element>
+Element
+minimumSSE2(const Element* values, size_type n)
+{
+  constexpr size_type LANES = sizeof(__m128i) / sizeof(Element);
+  __m128i acc = splat((Element)~(Element)0);
+  size_type i = 0;
+  for(; i + LANES <= n; i += LANES)
+  {
+    acc = lanesMin(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), Element());
+  }
+  Element lanes[LANES];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+  return std::min(minimumPortable(lanes, LANES), minimumPortable(values + i, n - i));
+}
+
+// AVX2 operations on unsigned lanes.
+
+__attribute__((target("avx2"))) inline __m256i splat256(std::uint8_t value) { return _mm256_set1_epi8(value); }
+__attribute__((target("avx2"))) inline __m256i splat256(std::uint16_t value) { return _mm256_set1_epi16(value); }
+
+__attribute__((target("avx2")))
+inline __m256i
+lanesMin256(__m256i a, __m256i b, std::uint8_t)
+{
+  return _mm256_min_epu8(a, b);
+}
+
+__attribute__((target("avx2")))
+inline __m256i
+lanesMin256(__m256i a, __m256i b, std::uint16_t)
+{
+  return _mm256_min_epu16(a, b);
+}
+
+__attribute__((target("avx2")))
+inline std::uint32_t
+atMostMask256(__m256i values, __m256i limit, std::uint8_t tag)
+{
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(lanesMin256(values, limit, tag), values));
+}
+
+__attribute__((target("avx2")))
+inline std::uint32_t
+atMostMask256(__m256i values, __m256i limit, std::uint16_t tag)
+{
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi16(lanesMin256(values, limit, tag), values));
+}
+
+template<class Element>
+__attribute__((target("avx2,bmi")))
+size_type
+firstAtMostAVX2(const Element* values, size_type n, Element limit)
+{
+  constexpr size_type LANES = sizeof(__m256i) / sizeof(Element);
+  __m256i lim = splat256(limit);
+  size_type i = 0;
+  for(; i + LANES <= n; i += LANES)
+  {
+    std::uint32_t mask = atMostMask256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), lim, limit);
+    if(mask != 0) { return i + __builtin_ctz(mask) / sizeof(Element); }
+  }
+  return i + firstAtMostSSE2(values + i, n - i, limit);
+}
+
+template<class Element>
+__attribute__((target("avx2,bmi")))
+size_type
+lastAtMostAVX2(const Element* values, size_type n, Element limit)
+{
+  constexpr size_type LANES = sizeof(__m256i) / sizeof(Element);
+  __m256i lim = splat256(limit);
+  size_type i = n;
+  for(; i >= LANES; i -= LANES)
+  {
+    std::uint32_t mask = atMostMask256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i - LANES)), lim, limit);
+    if(mask != 0) { return i - LANES + (31 - __builtin_clz(mask)) / sizeof(Element); }
+  }
+  size_type res = lastAtMostSSE2(values, i, limit);
+  return (res < i ? res : n);
+}
+
+template<class Element>
+__attribute__((target("avx2")))
+Element
+minimumAVX2(const Element* values, size_type n)
+{
+  constexpr size_type LANES = sizeof(__m256i) / sizeof(Element);
+  __m256i acc = splat256((Element)~(Element)0);
+  size_type i = 0;
+  for(; i + LANES <= n; i += LANES)
+  {
+    acc = lanesMin256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), Element());
+  }
+  Element lanes[LANES];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  return std::min(minimumPortable(lanes, LANES), minimumSSE2(values + i, n - i));
+}
+
+#endif
+
+bool
+useAVX2()
+{
+#ifdef GCSA_X86_KERNELS
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"));
+#else
+  return false;
+#endif
+}
+
+template<class Element>
+ScanKernels<Element>
+selectScanKernels()
+{
+#ifdef GCSA_X86_KERNELS
+  if(useAVX2())
+  {
+    return ScanKernels<Element> { firstAtMostAVX2<Element>, lastAtMostAVX2<Element>, minimumAVX2<Element> };
+  }
+  return ScanKernels<Element> { firstAtMostSSE2<Element>, lastAtMostSSE2<Element>, minimumSSE2<Element> };
+#else
+  return ScanKernels<Element> { firstAtMostPortable<Element>, lastAtMostPortable<Element>, minimumPortable<Element> };
+#endif
+}
+
+const ScanKernels<std::uint8_t>  byte_scan = selectScanKernels<std::uint8_t>();
+const ScanKernels<std::uint16_t> short_scan = selectScanKernels<std::uint16_t>();
+
+const std::string&
+LCPArray::kernelName()
+{
+#ifdef GCSA_X86_KERNELS
+  const static std::string name = (useAVX2() ? "avx2" : "sse2");
+#else
+  const static std::string name = "portable";
+#endif
+  return name;
+}
+
+template<class Element>
+inline const Element*
+valuePointer(const LCPArray& lcp, size_type i)
+{
+  return reinterpret_cast<const Element*>(lcp.lcp_values.data()) + i;
+}
+
+template<class Element>
+inline Element
+clampLimit(size_type limit)
+{
+  return std::min(limit, (size_type)(Element)~(Element)0);
+}
+
+/*
+  Scans over [from, to] in the data array. The at-most scans return lcp.notFound() if
+  there is no suitable position. minimum() returns the first minimal position.
+*/
+
+range_type
+firstAtMost(const LCPArray& lcp, size_type from, size_type to, size_type limit)
+{
+  size_type n = to + 1 - from, res = n;
+  switch(lcp.lcp_values.width())
+  {
+  case BYTE_BITS:
+    res = byte_scan.first_at_most(valuePointer<std::uint8_t>(lcp, from), n, clampLimit<std::uint8_t>(limit));
+    break;
+  case 2 * BYTE_BITS:
+    res = short_scan.first_at_most(valuePointer<std::uint16_t>(lcp, from), n, clampLimit<std::uint16_t>(limit));
+    break;
+  default:
+    for(res = 0; res < n && lcp[from + res] > limit; res++);
+  }
+  if(res < n) { return range_type(from + res, lcp[from + res]); }
+  return lcp.notFound();
+}
+
+range_type
+lastAtMost(const LCPArray& lcp, size_type from, size_type to, size_type limit)
+{
+  size_type n = to + 1 - from, res = n;
+  switch(lcp.lcp_values.width())
+  {
+  case BYTE_BITS:
+    res = byte_scan.last_at_most(valuePointer<std::uint8_t>(lcp, from), n, clampLimit<std::uint8_t>(limit));
+    break;
+  case 2 * BYTE_BITS:
+    res = short_scan.last_at_most(valuePointer<std::uint16_t>(lcp, from), n, clampLimit<std::uint16_t>(limit));
+    break;
+  default:
+    for(size_type i = n; i > 0; i--)
+    {
+      if(lcp[from + i - 1] <= limit) { res = i - 1; break; }
+    }
+  }
+  if(res < n) { return range_type(from + res, lcp[from + res]); }
+  return lcp.notFound();
+}
+
+range_type
+minimum(const LCPArray& lcp, size_type from, size_type to)
+{
+  switch(lcp.lcp_values.width())
+  {
+  case BYTE_BITS:
+    return firstAtMost(lcp, from, to, byte_scan.minimum(valuePointer<std::uint8_t>(lcp, from), to + 1 - from));
+  case 2 * BYTE_BITS:
+    return firstAtMost(lcp, from, to, short_scan.minimum(valuePointer<std::uint16_t>(lcp, from), to + 1 - from));
+  }
+  range_type res(from, lcp[from]);
+  for(size_type i = from + 1; i <= to; i++)
+  {
+    if(lcp[i] < res.second) { res = range_type(i, lcp[i]); }
+  }
+  return res;
+}
+
+/*
+  The positions i with comp(lcp[i], val) are exactly those with lcp[i] <= limit.
+  Returns false if there are no such positions.
+*/
+
+inline bool
+scanLimit(size_type val, const std::less<size_type>&, size_type& limit)
+{
+  if(val == 0) { return false; }
+  limit = val - 1;
+  return true;
+}
+
+inline bool
+scanLimit(size_type val, const std::less_equal<size_type>&, size_type& limit)
+{
+  limit = val;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Calls handler(i, value) for the first n values in the LCP file.
+template<class Handler>
+void
+readLCPFile(std::ifstream& in, size_type n, const std::string& filename, const Handler& handler)
+{
+  std::vector<InputGraph::lcp_type> buffer;
+  for(size_type i = 0; i < n; i += MEGABYTE)
+  {
+    buffer.resize(std::min(MEGABYTE, n - i));
+    if(!DiskIO::read(in, buffer.data(), buffer.size()))
+    {
+      std::cerr << "LCPArray::LCPArray(): Unexpected EOF in " << filename << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    for(size_type j = 0; j < buffer.size(); j++) { handler(i + j, buffer[j]); }
+  }
+}
+
+//------------------------------------------------------------------------------
+
 LCPArray::LCPArray(const InputGraph& graph, const ConstructionParameters& parameters)
 {
   double start = readTimer();
@@ -217,55 +698,98 @@ LCPArray::LCPArray(const InputGraph& graph, const ConstructionParameters& parame
   }
 
   this->header.branching = parameters.getLCPBranching();
+  this->header.size = fileSize(in) / sizeof(InputGraph::lcp_type);
+  size_type total_size = this->initLevels();
+
+  // Initialize data. We use bytes if the values fit, so that the scans can use the byte
+  // kernels, and 16 bits otherwise. The padding between the levels has the maximal value.
+  size_type max_value = 0;
+  readLCPFile(in, this->size(), graph.lcp_name,
+    [&max_value](size_type, size_type value) { max_value = std::max(max_value, value); });
+  size_type width = (max_value <= sdsl::bits::lo_set[BYTE_BITS] ? BYTE_BITS : 2 * BYTE_BITS);
+  this->data = sdsl::int_vector<0>(total_size, sdsl::bits::lo_set[width], width);
+  in.clear(); in.seekg(0);
+  readLCPFile(in, this->size(), graph.lcp_name,
+    [this](size_type i, size_type value) { this->data[i] = value; });
+  in.close();
+  this->buildTree();
+  this->lcp_values = IntVectorView(this->data);
+  if(parameters.getMappable()) { this->header.set(LCPHeader::MAPPABLE); }
 
+  if(Verbosity::level >= Verbosity::EXTENDED)
+  {
+    double seconds = readTimer() - start;
+    std::cerr << "LCPArray::LCPArray(): Construction: " << seconds << " seconds, "
+              << inGigabytes(memoryUsage()) << " GB" << std::endl;
+  }
+  if(Verbosity::level >= Verbosity::BASIC)
+  {
+    std::cerr << "LCPArray::LCPArray(): " << this->values() << " values at " << this->levels()
+              << " levels (branching factor " << this->branching() << ")" << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+LCPArray::size_type
+LCPArray::initLevels()
+{
   // Determine the number of levels.
-  this->header.size = fileSize(in);
   size_type level_count = 1, level_size = this->size();
   while(level_size > 1)
   {
     level_count++; level_size = (level_size + this->branching() - 1) / this->branching();
   }
 
-  // Initialize offsets.
+  // Initialize offsets. Each level after the leaves starts at a multiple of LEVEL_ALIGNMENT.
   this->offsets = sdsl::int_vector<64>(level_count + 1, 0);
   level_size = this->size();
   size_type total_size = 0;
   for(size_type level = 0; level < this->levels(); level++)
   {
     total_size += level_size;
+    if(level + 1 < this->levels())
+    {
+      total_size = ((total_size + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT) * LEVEL_ALIGNMENT;
+    }
     this->offsets[level + 1] = total_size;
     level_size = (level_size + this->branching() - 1) / this->branching();
   }
+  this->setLevelEnds();
 
-  // Initialize data.
-  this->data = sdsl::int_vector<0>(total_size, ~(uint8_t)0, 8);
-  if(!DiskIO::read(in, reinterpret_cast<uint8_t*>(this->data.data()), this->size()))
-  {
-    std::cerr << "LCPArray::LCPArray(): Unexpected EOF in " << graph.lcp_name << std::endl;
-    std::exit(EXIT_FAILURE);
-  }
-  in.close();
+  return total_size;
+}
+
+void
+LCPArray::buildTree()
+{
   for(size_type level = 0; level + 1 < this->levels(); level++)
   {
-    for(size_type i = this->offsets[level]; i < this->offsets[level + 1]; i++)
+    for(size_type i = this->offsets[level]; i < this->level_ends[level]; i++)
     {
       size_type par = rmtParent(*this, i, level);
       if(this->data[i] < this->data[par]) { this->data[par] = this->data[i]; }
     }
   }
-  sdsl::util::bit_compress(this->data);
+}
 
-  if(Verbosity::level >= Verbosity::EXTENDED)
-  {
-    double seconds = readTimer() - start;
-    std::cerr << "LCPArray::LCPArray(): Construction: " << seconds << " seconds, "
-              << inGigabytes(memoryUsage()) << " GB" << std::endl;
-  }
-  if(Verbosity::level >= Verbosity::BASIC)
-  {
-    std::cerr << "LCPArray::LCPArray(): " << this->values() << " values at " << this->levels()
-              << " levels (branching factor " << this->branching() << ")" << std::endl;
-  }
+void
+LCPArray::upgrade()
+{
+  // Version 1 has bit-compressed values and no padding between the levels. The leaves
+  // are the same, so we rebuild the tree from them. The old values may be in a mapping.
+  sdsl::int_vector<0> old_data; old_data.swap(this->data);
+  IntVectorView old_values = this->lcp_values;
+
+  size_type max_value = 0;
+  for(size_type i = 0; i < this->size(); i++) { max_value = std::max(max_value, old_values[i]); }
+  size_type width = (max_value <= sdsl::bits::lo_set[BYTE_BITS] ? BYTE_BITS : 2 * BYTE_BITS);
+  this->data = sdsl::int_vector<0>(this->initLevels(), sdsl::bits::lo_set[width], width);
+  for(size_type i = 0; i < this->size(); i++) { this->data[i] = old_values[i]; }
+  this->buildTree();
+
+  this->lcp_values = IntVectorView(this->data);
+  this->header.version = LCPHeader::VERSION;
 }
 
 //------------------------------------------------------------------------------
@@ -331,12 +855,9 @@ template<class Comparator>
 range_type
 psv(const LCPArray& lcp, size_type from, size_type to, size_type val, const Comparator& comp)
 {
-  while(to > from)
-  {
-    to--;
-    if(comp(lcp[to], val)) { return range_type(to, lcp[to]); }
-  }
-  return lcp.notFound();
+  size_type limit = 0;
+  if(to <= from || !scanLimit(val, comp, limit)) { return lcp.notFound(); }
+  return lastAtMost(lcp, from, to - 1, limit);
 }
 
 template<class Comparator>
@@ -388,11 +909,9 @@ template<class Comparator>
 range_type
 nsv(const LCPArray& lcp, size_type from, size_type to, size_type val, const Comparator& comp)
 {
-  for(size_type i = from; i <= to; i++)
-  {
-    if(comp(lcp[i], val)) { return range_type(i, lcp[i]); }
-  }
-  return lcp.notFound();
+  size_type limit = 0;
+  if(to < from || !scanLimit(val, comp, limit)) { return lcp.notFound(); }
+  return firstAtMost(lcp, from, to, limit);
 }
 
 template<class Comparator>
@@ -437,25 +956,25 @@ LCPArray::nsev(size_type pos) const
 //------------------------------------------------------------------------------
 
 inline void
-updateRes(const LCPArray& lcp, range_type& res, size_type i)
+updateRes(range_type& res, range_type candidate)
 {
-  if(lcp.data[i] < res.second) { res.first = i; res.second = lcp.data[i]; }
+  if(candidate.second < res.second) { res = candidate; }
 }
 
 range_type
 LCPArray::rmq(size_type sp, size_type ep) const
 {
   if(sp > ep || ep >= this->size()) { return this->notFound(); }
-  if(sp == ep) { return range_type(sp, this->data[sp]); }
+  if(sp == ep) { return range_type(sp, (*this)[sp]); }
 
   /*
     Search for a subtree containing the rmq, maintaining the following invariants:
       - left < right
       - nodes before subtree(left) are processed
-      - nodes after subtree(right) are in tail
+      - ranges of nodes after subtree(right) are in tail
       - res contains (i, lcp[i]) for the rmq in the processed range
   */
-  range_type res(this->values(), this->size());
+  range_type res(this->values(), ~(size_type)0);
   size_type level = 0, left = sp, right = ep;
   std::stack<range_type> tail;
   while(true)
@@ -463,7 +982,7 @@ LCPArray::rmq(size_type sp, size_type ep) const
     size_type left_par = rmtParent(*this, left, level), right_par = rmtParent(*this, right, level);
     if(left_par == right_par)
     {
-      for(size_type i = left; i <= right; i++) { updateRes(*this, res, i); }
+      updateRes(res, minimum(*this, left, right));
       break;
     }
 
@@ -471,7 +990,7 @@ LCPArray::rmq(size_type sp, size_type ep) const
     if(left != left_child)
     {
       size_type last_child = rmtLastSibling(*this, left_child, level);
-      for(size_type i = left; i <= last_child; i++) { updateRes(*this, res, i); }
+      updateRes(res, minimum(*this, left, last_child));
       left_par++;
     }
 
@@ -479,13 +998,13 @@ LCPArray::rmq(size_type sp, size_type ep) const
     if(right != right_child)
     {
       size_type first_child = rmtFirstSibling(*this, right_child, level);
-      for(size_type i = right; i >= first_child; i--) { tail.push(range_type(i, this->data[i])); }
+      tail.push(range_type(first_child, right));
       right_par--;
     }
 
     if(left_par >= right_par)
     {
-      if(left_par == right_par) { updateRes(*this, res, left_par); }
+      if(left_par == right_par) { updateRes(res, range_type(left_par, (*this)[left_par])); }
       break;
     }
     left = left_par; right = right_par; level++;
@@ -495,15 +1014,15 @@ LCPArray::rmq(size_type sp, size_type ep) const
   while(!(tail.empty()))
   {
     range_type temp = tail.top(); tail.pop();
-    if(temp.second < res.second) { res = temp; }
+    updateRes(res, minimum(*this, temp.first, temp.second));
   }
 
   // Find the leftmost leaf in subtree(res.first) containing LCP value res.second.
   level = rmtLevel(*this, res.first);
   while(level > 0)
   {
-    res.first = rmtFirstChild(*this, res.first, level); level--;
-    while(this->data[res.first] != res.second) { res.first++; }
+    size_type first_child = rmtFirstChild(*this, res.first, level); level--;
+    res.first = firstAtMost(*this, first_child, rmtLastSibling(*this, first_child, level), res.second).first;
   }
 
   return res;
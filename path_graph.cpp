@@ -178,6 +178,47 @@ PathNode::print(std::ostream& out, const rank_type* labels) const
 
 //------------------------------------------------------------------------------
 
+void
+BlockCodec<PathNode>::encode(const PathNode* data, size_type n, std::vector<byte_type>& output)
+{
+  node_type prev_from = 0;
+  size_type next_pointer = 0;
+  for(size_type i = 0; i < n; i++)
+  {
+    const PathNode& path = data[i];
+    ByteCode::write(output, ByteCode::encode(prev_from, path.from)); prev_from = path.from;
+    ByteCode::write(output, (path.sorted() ? 0 : ByteCode::encode(path.from, path.to) + 1));
+    output.push_back(path.predecessors());
+    output.push_back(path.order());
+    output.push_back(path.lcp());
+    ByteCode::write(output, ByteCode::encode(next_pointer, path.pointer()));
+    next_pointer = path.pointer() + path.ranks();
+  }
+}
+
+bool
+BlockCodec<PathNode>::decode(const std::vector<byte_type>& input, PathNode* data, size_type n)
+{
+  node_type prev_from = 0;
+  size_type next_pointer = 0;
+  for(size_type i = 0, j = 0; i < n; i++)
+  {
+    PathNode& path = data[i];
+    path.from = ByteCode::decode(prev_from, ByteCode::read(input, j)); prev_from = path.from;
+    size_type to_code = ByteCode::read(input, j);
+    if(to_code == 0) { path.makeSorted(); }
+    else { path.to = ByteCode::decode(path.from, to_code - 1); }
+    if(j + 3 > input.size()) { return false; }
+    path.fields = input[j] | ((size_type)input[j + 1] << 8) | ((size_type)input[j + 2] << 16); j += 3;
+    path.setPointer(ByteCode::decode(next_pointer, ByteCode::read(input, j)));
+    next_pointer = path.pointer() + path.ranks();
+    if(i + 1 == n) { return (j == input.size()); }
+  }
+  return input.empty();
+}
+
+//------------------------------------------------------------------------------
+
 LCP::LCP()
 {
 }
@@ -257,14 +298,16 @@ LCP::swap(LCP& another)
 
 /*
   This structure combines a PathNode and its label. It also stores the identifier of
-  its source file.
+  its source file. The label has space for paths of order up to LENGTH and one
+  diverging rank.
 */
 
+template<size_type LENGTH>
 struct PriorityNode
 {
   typedef PathLabel::rank_type rank_type;
 
-  constexpr static size_type LABEL_LENGTH = PathLabel::LABEL_LENGTH;
+  constexpr static size_type LABEL_LENGTH = LENGTH;
   constexpr static rank_type NO_RANK = PathLabel::NO_RANK;
 
   rank_type file;
@@ -289,8 +332,148 @@ struct PriorityNode
   inline size_type bytes() const { return this->node.bytes(); }
 };
 
-constexpr size_type PriorityNode::LABEL_LENGTH;
-constexpr PriorityNode::rank_type PriorityNode::NO_RANK;
+template<size_type LENGTH> constexpr size_type PriorityNode<LENGTH>::LABEL_LENGTH;
+template<size_type LENGTH> constexpr typename PriorityNode<LENGTH>::rank_type PriorityNode<LENGTH>::NO_RANK;
+
+//------------------------------------------------------------------------------
+
+/*
+  MSD radix sort for PathNodes by their first labels. The result is in the same order
+  as with PathFirstComparator. The paths are first partitioned into buckets by their
+  first ranks, and the buckets are sorted in parallel. Each level of recursion sorts a
+  range of paths with the same label prefix by the rank at the current depth using LSD
+  counting sort on 8-bit digits of the key. The key is 0 if the label has ended, and
+  rank + 1 otherwise, so shorter labels come first.
+*/
+
+struct RadixEntry
+{
+  std::uint64_t key;
+  size_type     path;
+};
+
+struct PathRadixSorter
+{
+  typedef PathNode::rank_type rank_type;
+
+  const std::vector<PathNode>&  paths;
+  const std::vector<rank_type>& labels;
+  std::vector<RadixEntry>       entries, buffer;
+
+  constexpr static size_type RADIX_BUCKETS   = 256;
+  constexpr static size_type RADIX_THRESHOLD = 32;  // Use comparison sort for shorter ranges.
+  constexpr static size_type DIGIT_BITS      = 8;
+  constexpr static size_type DIGITS          = 1 << DIGIT_BITS;
+
+  PathRadixSorter(const std::vector<PathNode>& _paths, const std::vector<rank_type>& _labels);
+
+  // After sorting, entries[i].path is the i-th path in sorted order.
+  void sort();
+
+  // The buckets partition first ranks [0, rank_limit) into RADIX_BUCKETS ranges.
+  inline static size_type bucket(rank_type rank, size_type rank_limit)
+  {
+    return (rank * RADIX_BUCKETS) / rank_limit;
+  }
+
+  void sortRange(size_type from, size_type to, size_type depth);
+};
+
+constexpr size_type PathRadixSorter::RADIX_BUCKETS;
+constexpr size_type PathRadixSorter::RADIX_THRESHOLD;
+constexpr size_type PathRadixSorter::DIGIT_BITS;
+constexpr size_type PathRadixSorter::DIGITS;
+
+PathRadixSorter::PathRadixSorter(const std::vector<PathNode>& _paths, const std::vector<rank_type>& _labels) :
+  paths(_paths), labels(_labels)
+{
+}
+
+void
+PathRadixSorter::sort()
+{
+  size_type rank_limit = 1;
+  for(size_type i = 0; i < this->paths.size(); i++)
+  {
+    rank_limit = std::max(rank_limit, (size_type)(this->labels[this->paths[i].pointer()]) + 1);
+  }
+
+  // Partition the paths into buckets by the first rank.
+  std::vector<size_type> offsets(RADIX_BUCKETS + 1, 0);
+  for(size_type i = 0; i < this->paths.size(); i++)
+  {
+    offsets[bucket(this->labels[this->paths[i].pointer()], rank_limit) + 1]++;
+  }
+  for(size_type i = 1; i <= RADIX_BUCKETS; i++) { offsets[i] += offsets[i - 1]; }
+  this->entries.resize(this->paths.size()); this->buffer.resize(this->paths.size());
+  {
+    std::vector<size_type> tails(offsets.begin(), offsets.end() - 1);
+    for(size_type i = 0; i < this->paths.size(); i++)
+    {
+      size_type curr = bucket(this->labels[this->paths[i].pointer()], rank_limit);
+      this->entries[tails[curr]].path = i; tails[curr]++;
+    }
+  }
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(size_type i = 0; i < RADIX_BUCKETS; i++)
+  {
+    if(offsets[i + 1] - offsets[i] > 1) { this->sortRange(offsets[i], offsets[i + 1], 0); }
+  }
+  sdsl::util::clear(this->buffer);
+}
+
+void
+PathRadixSorter::sortRange(size_type from, size_type to, size_type depth)
+{
+  if(to - from <= RADIX_THRESHOLD)
+  {
+    PathFirstComparator first_c(this->labels);
+    std::sort(this->entries.begin() + from, this->entries.begin() + to,
+      [&](const RadixEntry& a, const RadixEntry& b) { return first_c(this->paths[a.path], this->paths[b.path]); });
+    return;
+  }
+
+  std::uint64_t max_key = 0;
+  for(size_type i = from; i < to; i++)
+  {
+    const PathNode& path = this->paths[this->entries[i].path];
+    std::uint64_t key = (depth < path.order() ? (std::uint64_t)(this->labels[path.pointer() + depth]) + 1 : 0);
+    this->entries[i].key = key; max_key = std::max(max_key, key);
+  }
+
+  // LSD counting sort by the key, skipping digits with a single value.
+  RadixEntry* source = this->entries.data();
+  RadixEntry* target = this->buffer.data();
+  for(size_type shift = 0; shift < WORD_BITS && (max_key >> shift) > 0; shift += DIGIT_BITS)
+  {
+    size_type counts[DIGITS] = {};
+    for(size_type i = from; i < to; i++) { counts[(source[i].key >> shift) & (DIGITS - 1)]++; }
+    if(counts[(source[from].key >> shift) & (DIGITS - 1)] == to - from) { continue; }
+    for(size_type digit = 0, total = from; digit < DIGITS; digit++)
+    {
+      size_type temp = counts[digit]; counts[digit] = total; total += temp;
+    }
+    for(size_type i = from; i < to; i++)
+    {
+      target[counts[(source[i].key >> shift) & (DIGITS - 1)]++] = source[i];
+    }
+    std::swap(source, target);
+  }
+  if(source != this->entries.data())
+  {
+    std::copy(source + from, source + to, this->entries.data() + from);
+  }
+
+  // Sort the ranges of paths with the same rank at this depth by the next rank.
+  for(size_type i = from; i < to; )
+  {
+    size_type j = i + 1;
+    while(j < to && this->entries[j].key == this->entries[i].key) { j++; }
+    if(this->entries[i].key != 0 && j - i > 1) { this->sortRange(i, j, depth + 1); }
+    i = j;
+  }
+}
 
 //------------------------------------------------------------------------------
 
@@ -304,34 +487,40 @@ struct PathGraphBuilder
   PathGraph graph;
   std::vector<WriteBuffer<PathNode>> path_files;
   std::vector<WriteBuffer<PathNode::rank_type>> rank_files;
+  std::vector<size_type> rank_limits; // Largest first rank + 1 in each file.
   size_type limit;  // Bytes of disk space.
 
   constexpr static size_type WRITE_BUFFER_SIZE = MEGABYTE;  // PathNodes per thread.
 
-  PathGraphBuilder(size_type file_count, size_type path_order, size_type step, size_type size_limit);
+  // Files larger than this are sorted by spilling the radix sort buckets to disk.
+  constexpr static size_type SORT_BUFFER_SIZE = 8 * GIGABYTE;
+
+  PathGraphBuilder(size_type file_count, size_type path_order, size_type step, size_type size_limit, bool compress);
   void close();
 
   /*
     The file number is assumed to be valid.
     The first call is not thread safe, while the bulk write() is.
   */
-  void write(PriorityNode& path);
+  template<size_type LENGTH> void write(PriorityNode<LENGTH>& path);
   void write(std::vector<PathNode>& paths, std::vector<PathNode::rank_type>& labels, size_type file);
 
   void sort(size_type file);
 };
 
 constexpr size_type PathGraphBuilder::WRITE_BUFFER_SIZE;
+constexpr size_type PathGraphBuilder::SORT_BUFFER_SIZE;
 
-PathGraphBuilder::PathGraphBuilder(size_type file_count, size_type path_order, size_type step, size_type size_limit) :
-  graph(file_count, path_order, step),
-  path_files(file_count), rank_files(file_count),
+PathGraphBuilder::PathGraphBuilder(size_type file_count, size_type path_order, size_type step, size_type size_limit,
+  bool compress) :
+  graph(file_count, path_order, step, compress),
+  path_files(file_count), rank_files(file_count), rank_limits(file_count, 1),
   limit(size_limit)
 {
   for(size_type file = 0; file < file_count; file++)
   {
-    this->path_files[file].open(this->graph.path_names[file]);
-    this->rank_files[file].open(this->graph.rank_names[file]);
+    this->path_files[file].open(this->graph.path_names[file], MEGABYTE, compress);
+    this->rank_files[file].open(this->graph.rank_names[file], MEGABYTE, compress);
   }
 }
 
@@ -358,14 +547,16 @@ writePath(PathNode& path, const PathNode::rank_type* labels,
   for(size_type i = old_ptr; i < limit; i++) { rank_file.push_back(labels[i]); }
 }
 
+template<size_type LENGTH>
 void
-PathGraphBuilder::write(PriorityNode& path)
+PathGraphBuilder::write(PriorityNode<LENGTH>& path)
 {
   if(this->graph.bytes() + path.bytes() > this->limit)
   {
     std::cerr << "PathGraphBuilder::write(): Size limit exceeded, construction aborted" << std::endl;
     std::exit(EXIT_FAILURE);
   }
+  this->rank_limits[path.file] = std::max(this->rank_limits[path.file], (size_type)(path.label[0]) + 1);
   writePath(path.node, path.label, this->path_files[path.file], this->rank_files[path.file]);
 
   this->graph.path_counts[path.file]++; this->graph.path_count++;
@@ -386,6 +577,7 @@ PathGraphBuilder::write(std::vector<PathNode>& paths, std::vector<PathNode::rank
     }
     for(size_type i = 0; i < paths.size(); i++)
     {
+      this->rank_limits[file] = std::max(this->rank_limits[file], (size_type)(labels[paths[i].pointer()]) + 1);
       writePath(paths[i], labels.data(), this->path_files[file], this->rank_files[file]);
     }
     this->graph.path_counts[file] += paths.size(); this->graph.path_count += paths.size();
@@ -394,24 +586,136 @@ PathGraphBuilder::write(std::vector<PathNode>& paths, std::vector<PathNode::rank
   paths.clear(); labels.clear();
 }
 
+// Appends the buffered paths and labels to the files of the bucket graph.
+void
+spillBuckets(PathGraph& buckets, std::vector<std::vector<PathNode>>& paths,
+  std::vector<std::vector<PathNode::rank_type>>& labels)
+{
+  for(size_type bucket = 0; bucket < buckets.files(); bucket++)
+  {
+    if(paths[bucket].empty()) { continue; }
+    std::ofstream path_file(buckets.path_names[bucket], std::ios_base::binary | std::ios_base::app);
+    std::ofstream rank_file(buckets.rank_names[bucket], std::ios_base::binary | std::ios_base::app);
+    if(!path_file || !rank_file)
+    {
+      std::cerr << "spillBuckets(): Cannot open the files for bucket " << bucket << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    for(size_type i = 0; i < paths[bucket].size(); i++)
+    {
+      paths[bucket][i].setPointer(paths[bucket][i].pointer() + buckets.rank_counts[bucket]);
+    }
+    DiskIO::write(path_file, paths[bucket].data(), paths[bucket].size());
+    DiskIO::write(rank_file, labels[bucket].data(), labels[bucket].size());
+    path_file.close(); rank_file.close();
+
+    buckets.path_counts[bucket] += paths[bucket].size(); buckets.path_count += paths[bucket].size();
+    buckets.rank_counts[bucket] += labels[bucket].size(); buckets.rank_count += labels[bucket].size();
+    paths[bucket].clear(); labels[bucket].clear();
+  }
+}
+
+/*
+  Distributes the paths in the file into the files of the part graph in a single pass.
+  Each path is written to part targets(path, first_rank).first and, unless it is
+  NO_PART, to part targets(path, first_rank).second. The parts are buffered in memory
+  and appended to the files when the buffers exceed buffer_size bytes.
+*/
+
+const size_type NO_PART = ~(size_type)0;
+
+template<class Targets>
+void
+partitionPaths(const PathGraph& graph, size_type file, PathGraph& parts, const Targets& targets, size_type buffer_size)
+{
+  ReadBuffer<PathNode> path_file;
+  ReadBuffer<PathNode::rank_type> rank_file;
+  path_file.open(graph.path_names[file], MEGABYTE, graph.compressed);
+  rank_file.open(graph.rank_names[file], MEGABYTE, graph.compressed);
+
+  std::vector<std::vector<PathNode>> paths(parts.files());
+  std::vector<std::vector<PathNode::rank_type>> labels(parts.files());
+  size_type buffered = 0;
+  for(size_type i = 0; i < graph.path_counts[file]; i++)
+  {
+    path_file.seek(i);
+    PathNode path = path_file[i];
+    size_type pointer = path.pointer();
+    rank_file.seek(pointer);
+    range_type part = targets(path, rank_file[pointer]);
+    for(size_type curr : { part.first, part.second })
+    {
+      if(curr == NO_PART) { continue; }
+      path.setPointer(labels[curr].size());
+      paths[curr].push_back(path);
+      for(size_type j = 0; j < path.ranks(); j++) { labels[curr].push_back(rank_file[pointer + j]); }
+      buffered += path.bytes();
+    }
+    if(buffered >= buffer_size) { spillBuckets(parts, paths, labels); buffered = 0; }
+  }
+  spillBuckets(parts, paths, labels);
+  path_file.close(); rank_file.close();
+}
+
+// Radix sort buckets by the first rank.
+struct RankTargets
+{
+  size_type rank_limit;
+
+  explicit RankTargets(size_type limit) : rank_limit(limit) { }
+
+  inline range_type operator() (const PathNode&, PathNode::rank_type first_rank) const
+  {
+    return range_type(PathRadixSorter::bucket(first_rank, this->rank_limit), NO_PART);
+  }
+};
+
 void
 PathGraphBuilder::sort(size_type file)
 {
   this->path_files[file].close();
   this->rank_files[file].close();
 
-  std::vector<PathNode> paths;
-  std::vector<PathNode::rank_type> labels;
-  this->graph.read(paths, labels, file);
-
-  PathFirstComparator first_c(labels);
-  parallelQuickSort(paths.begin(), paths.end(), first_c);
+  size_type file_bytes = this->graph.path_counts[file] * sizeof(PathNode) +
+                         this->graph.rank_counts[file] * sizeof(PathNode::rank_type);
+  if(file_bytes <= SORT_BUFFER_SIZE)
+  {
+    std::vector<PathNode> paths;
+    std::vector<PathNode::rank_type> labels;
+    this->graph.read(paths, labels, file);
+    PathRadixSorter sorter(paths, labels);
+    sorter.sort();
 
-  this->path_files[file].open(this->graph.path_names[file]);
-  this->rank_files[file].open(this->graph.rank_names[file]);
-  for(size_type i = 0; i < paths.size(); i++)
+    this->path_files[file].open(this->graph.path_names[file], MEGABYTE, this->graph.compressed);
+    this->rank_files[file].open(this->graph.rank_names[file], MEGABYTE, this->graph.compressed);
+    for(size_type i = 0; i < sorter.entries.size(); i++)
+    {
+      writePath(paths[sorter.entries[i].path], labels.data(), this->path_files[file], this->rank_files[file]);
+    }
+  }
+  else
   {
-    writePath(paths[i], labels.data(), this->path_files[file], this->rank_files[file]);
+    // Sort the buckets one at a time. A bucket must still fit in memory.
+    PathGraph buckets(PathRadixSorter::RADIX_BUCKETS, this->graph.k(), this->graph.step());
+    partitionPaths(this->graph, file, buckets, RankTargets(this->rank_limits[file]), SORT_BUFFER_SIZE / 2);
+
+    this->path_files[file].open(this->graph.path_names[file], MEGABYTE, this->graph.compressed);
+    this->rank_files[file].open(this->graph.rank_names[file], MEGABYTE, this->graph.compressed);
+    for(size_type bucket = 0; bucket < buckets.files(); bucket++)
+    {
+      if(buckets.path_counts[bucket] == 0) { continue; }
+      std::vector<PathNode> paths;
+      std::vector<PathNode::rank_type> labels;
+      buckets.read(paths, labels, bucket);
+      TempFile::remove(buckets.path_names[bucket]);
+      TempFile::remove(buckets.rank_names[bucket]);
+      PathRadixSorter sorter(paths, labels);
+      sorter.sort();
+      for(size_type i = 0; i < sorter.entries.size(); i++)
+      {
+        writePath(paths[sorter.entries[i].path], labels.data(), this->path_files[file], this->rank_files[file]);
+      }
+    }
   }
 
   if(Verbosity::level >= Verbosity::FULL)
@@ -423,8 +727,6 @@ PathGraphBuilder::sort(size_type file)
 
 //------------------------------------------------------------------------------
 
-struct PathGraphMerger;
-
 struct PathRange
 {
   size_type  from, to;
@@ -433,40 +735,75 @@ struct PathRange
   inline range_type range() const { return range_type(this->from, this->to); }
   inline size_type length() const { return this->to + 1 - this->from; }
 
-  PathRange(size_type start, size_type stop, range_type _left_lcp, PathGraphMerger& merger);
+  template<class Merger>
+  PathRange(size_type start, size_type stop, range_type _left_lcp, Merger& merger);
+};
+
+/*
+  The merged stream of paths can be partitioned into label intervals that are processed
+  independently by different threads. An interval starts from the given offset in each
+  file, contains the next 'length' paths, and its first path has lcp 'left_lcp' with the
+  preceding path.
+*/
+
+struct MergeInterval
+{
+  std::vector<size_type> offsets;
+  size_type              length;
+  range_type             left_lcp;
+
+  // The entire graph.
+  explicit MergeInterval(const PathGraph& graph);
 };
 
+MergeInterval::MergeInterval(const PathGraph& graph) :
+  offsets(graph.files(), 0), length(graph.size()), left_lcp(0, 0)
+{
+}
+
 /*
   This structure reads a buffered stream of PriorityNodes in sorted order and outputs a
-  stream of ranges of PriorityNodes with the same label.
+  stream of ranges of PriorityNodes with the same label. The stream may start from the
+  beginning of a MergeInterval. In that case, the iteration stops at the end of the
+  interval, but the buffer may extend beyond it. The paths must have order at most
+  LENGTH.
 */
 
+template<size_type LENGTH>
 struct PathGraphMerger
 {
+  typedef PriorityNode<LENGTH> priority_type;
+
   const PathGraph&                              graph;
   const LCP&                                    lcp;
 
   // Buffers.
   std::deque<PathRange>                         ranges;
-  BufferWindow<PriorityNode>                    buffer;
+  BufferWindow<priority_type>                   buffer;
 
   // Priority queue.
   std::vector<ReadBuffer<PathNode>>             path_files;
   std::vector<ReadBuffer<PathNode::rank_type>>  rank_files;
   std::vector<size_type>                        offsets;
-  PriorityQueue<PriorityNode>                   inputs;
+  PriorityQueue<priority_type>                  inputs;
+
+  // Paths remaining in the stream, paths in the interval, and lcp before the interval.
+  size_type                                     path_count, limit;
+  range_type                                    first_lcp;
 
   PathGraphMerger(const PathGraph& path_graph, const LCP& kmer_lcp);
+  PathGraphMerger(const PathGraph& path_graph, const LCP& kmer_lcp, const MergeInterval& interval,
+    size_type buffer_size = MEGABYTE);
   void close();
 
-  inline size_type size() const { return this->graph.size(); }
+  inline size_type size() const { return this->path_count; }
 
   /*
     Iterates through ranges of paths with the same label.
   */
   range_type first();
   range_type next();
-  inline bool atEnd(range_type range) const { return (range.first >= this->size()); }
+  inline bool atEnd(range_type range) const { return (range.first >= this->limit); }
 
   inline range_type range_lcp(size_type i, size_type j) const // i < j
   {
@@ -501,26 +838,36 @@ struct PathGraphMerger
   void bufferNext();
 
   // Read the next PriorityNode from the file.
-  void read(PriorityNode& path);
+  void read(priority_type& path);
 };
 
-PathGraphMerger::PathGraphMerger(const PathGraph& path_graph, const LCP& kmer_lcp) :
+template<size_type LENGTH>
+PathGraphMerger<LENGTH>::PathGraphMerger(const PathGraph& path_graph, const LCP& kmer_lcp) :
+  PathGraphMerger(path_graph, kmer_lcp, MergeInterval(path_graph))
+{
+}
+
+template<size_type LENGTH>
+PathGraphMerger<LENGTH>::PathGraphMerger(const PathGraph& path_graph, const LCP& kmer_lcp, const MergeInterval& interval,
+  size_type buffer_size) :
   graph(path_graph), lcp(kmer_lcp),
   path_files(path_graph.files()), rank_files(path_graph.files()),
-  offsets(path_graph.files()), inputs(path_graph.files())
+  offsets(interval.offsets), inputs(path_graph.files()),
+  path_count(path_graph.size()), limit(interval.length), first_lcp(interval.left_lcp)
 {
   for(size_type file = 0; file < path_graph.files(); file++)
   {
-    this->path_files[file].open(path_graph.path_names[file]);
-    this->rank_files[file].open(path_graph.rank_names[file]);
-    this->offsets[file] = 0;
+    this->path_files[file].open(path_graph.path_names[file], buffer_size, path_graph.compressed);
+    this->rank_files[file].open(path_graph.rank_names[file], buffer_size, path_graph.compressed);
+    this->path_count -= this->offsets[file];
     this->inputs[file].file = file; this->read(this->inputs[file]);
   }
   this->inputs.heapify();
 }
 
+template<size_type LENGTH>
 void
-PathGraphMerger::close()
+PathGraphMerger<LENGTH>::close()
 {
   sdsl::util::clear(this->ranges);
   sdsl::util::clear(this->buffer);
@@ -536,8 +883,9 @@ PathGraphMerger::close()
   this->inputs.clear();
 }
 
+template<size_type LENGTH>
 range_type
-PathGraphMerger::first()
+PathGraphMerger<LENGTH>::first()
 {
   if(this->buffer.offset > 0)
   {
@@ -546,12 +894,13 @@ PathGraphMerger::first()
   }
   this->ranges.clear();
 
-  this->ranges.push_back(PathRange(0, this->rangeEnd(0), range_type(0, 0), *this));
+  this->ranges.push_back(PathRange(0, this->rangeEnd(0), this->first_lcp, *this));
   return this->ranges.front().range();
 }
 
+template<size_type LENGTH>
 range_type
-PathGraphMerger::next()
+PathGraphMerger<LENGTH>::next()
 {
   PathRange temp = this->ranges.front(); this->ranges.pop_front();
   if(this->ranges.empty())
@@ -563,9 +912,10 @@ PathGraphMerger::next()
   return this->ranges.front().range();
 }
 
+template<size_type LENGTH>
 template<class FromComparator>
 range_type
-PathGraphMerger::extendRange(FromComparator& comp)
+PathGraphMerger<LENGTH>::extendRange(FromComparator& comp)
 {
   PathRange range = this->ranges.front();
   size_type curr = 1;
@@ -598,8 +948,9 @@ PathGraphMerger::extendRange(FromComparator& comp)
   return range.range();
 }
 
+template<size_type LENGTH>
 void
-PathGraphMerger::mergePathNodes()
+PathGraphMerger<LENGTH>::mergePathNodes()
 {
   PathRange& range = this->ranges.front();
   if(range.length() == 1)
@@ -627,8 +978,9 @@ PathGraphMerger::mergePathNodes()
   }
 }
 
+template<size_type LENGTH>
 size_type
-PathGraphMerger::rangeEnd(size_type start)
+PathGraphMerger<LENGTH>::rangeEnd(size_type start)
 {
   if(!(this->buffer.buffered(start))) { this->bufferNext(); }
 
@@ -642,27 +994,35 @@ PathGraphMerger::rangeEnd(size_type start)
   return stop;
 }
 
+template<size_type LENGTH>
 void
-PathGraphMerger::bufferNext()
+PathGraphMerger<LENGTH>::bufferNext()
 {
   this->buffer.push_back(this->inputs[0]);  // Add to the buffer.
   this->read(this->inputs[0]);  // Read the next.
   this->inputs.down(0); // Restore heap order.
 }
 
+template<size_type LENGTH>
 void
-PathGraphMerger::read(PriorityNode& path)
+PathGraphMerger<LENGTH>::read(priority_type& path)
 {
   if(this->offsets[path.file] >= this->graph.path_counts[path.file])
   {
     path.node.setOrder(1);
     path.node.setLCP(1);
-    path.label[0] = PriorityNode::NO_RANK;
+    path.label[0] = priority_type::NO_RANK;
   }
   else
   {
     this->path_files[path.file].seek(this->offsets[path.file]);
     path.node = this->path_files[path.file][this->offsets[path.file]];
+    if(path.node.order() > LENGTH)
+    {
+      std::cerr << "PathGraphMerger::read(): Path order " << path.node.order()
+                << " exceeds label length " << LENGTH << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
     this->rank_files[path.file].seek(path.node.pointer());
     for(size_type i = 0; i < path.node.ranks(); i++)
     {
@@ -673,7 +1033,8 @@ PathGraphMerger::read(PriorityNode& path)
   }
 }
 
-PathRange::PathRange(size_type start, size_type stop, range_type _left_lcp, PathGraphMerger& merger) :
+template<class Merger>
+PathRange::PathRange(size_type start, size_type stop, range_type _left_lcp, Merger& merger) :
   from(start), to(stop),
   left_lcp(_left_lcp),
   range_lcp(0, 0),
@@ -685,13 +1046,13 @@ PathRange::PathRange(size_type start, size_type stop, range_type _left_lcp, Path
 
 //------------------------------------------------------------------------------
 
-PathGraph::PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_labels)
+PathGraph::PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_labels, bool compress)
 {
   this->path_count = 0; this->rank_count = 0; this->range_count = 0;
   this->order = source.k(); this->doubling_steps = 0;
   this->unique = UNKNOWN; this->redundant = UNKNOWN;
   this->unsorted = UNKNOWN; this->nondeterministic = UNKNOWN;
-  this->delete_files = true;
+  this->delete_files = true; this->compressed = compress;
 
   for(size_type file = 0; file < source.files(); file++)
   {
@@ -712,8 +1073,75 @@ PathGraph::PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_lab
     }
 
     // Convert the KMers to PathNodes.
-    WriteBuffer<PathNode> path_buffer(path_name);
-    WriteBuffer<PathNode::rank_type> rank_buffer(rank_name);
+    WriteBuffer<PathNode> path_buffer(path_name, MEGABYTE, this->compressed);
+    WriteBuffer<PathNode::rank_type> rank_buffer(rank_name, MEGABYTE, this->compressed);
+    for(size_type i = 0; i < kmers.size(); i++)
+    {
+      path_buffer.push_back(PathNode(kmers[i], rank_buffer));
+    }
+    this->path_counts.push_back(path_buffer.size()); this->path_count += path_buffer.size();
+    this->rank_counts.push_back(rank_buffer.size()); this->rank_count += rank_buffer.size();
+    path_buffer.close(); rank_buffer.close();
+  }
+
+  if(Verbosity::level >= Verbosity::EXTENDED)
+  {
+    std::cerr << "PathGraph::PathGraph(): " << this->size() << " paths with "
+              << this->ranks() << " ranks" << std::endl;
+    std::cerr << "PathGraph::PathGraph(): " << inGigabytes(this->bytes()) << " GB in "
+              << this->files() << " file(s)" << std::endl;
+  }
+}
+
+PathGraph::PathGraph(InputGraph& source, std::vector<key_type>& keys, std::vector<node_type>& from_nodes, bool compress)
+{
+  this->path_count = 0; this->rank_count = 0; this->range_count = 0;
+  this->order = 0; this->doubling_steps = 0;
+  this->unique = UNKNOWN; this->redundant = UNKNOWN;
+  this->unsorted = UNKNOWN; this->nondeterministic = UNKNOWN;
+  this->delete_files = true; this->compressed = compress;
+
+  sdsl::util::clear(keys); sdsl::util::clear(from_nodes);
+  keys.reserve(source.size()); from_nodes.reserve(source.size());
+  std::vector<size_type> key_offsets(1, 0);
+
+  for(size_type file = 0; file < source.files(); file++)
+  {
+    std::string path_name = TempFile::getName(PREFIX);
+    this->path_names.push_back(path_name);
+    std::string rank_name = TempFile::getName(PREFIX);
+    this->rank_names.push_back(rank_name);
+
+    // Read KMers and sort them.
+    std::vector<KMer> kmers;
+    source.consume(kmers, file);
+    parallelQuickSort(kmers.begin(), kmers.end());
+
+    // Collect the start nodes.
+    std::vector<node_type> file_from(kmers.size());
+    #pragma omp parallel for schedule(static)
+    for(size_type i = 0; i < kmers.size(); i++) { file_from[i] = kmers[i].from; }
+    Node::map(file_from, source.mapping);
+    removeDuplicates(file_from, true);
+    from_nodes.insert(from_nodes.end(), file_from.begin(), file_from.end());
+    sdsl::util::clear(file_from);
+
+    // Merge the keys sharing the same label and replace the labels with their ranks
+    // among the labels in this file.
+    for(size_type i = 0; i < kmers.size(); i++)
+    {
+      if(keys.size() > key_offsets.back() && Key::label(keys.back()) == Key::label(kmers[i].key))
+      {
+        keys.back() = Key::merge(keys.back(), kmers[i].key);
+      }
+      else { keys.push_back(kmers[i].key); }
+      kmers[i].key = Key::replace(kmers[i].key, keys.size() - 1 - key_offsets.back());
+    }
+    key_offsets.push_back(keys.size());
+
+    // Convert the KMers to PathNodes.
+    WriteBuffer<PathNode> path_buffer(path_name, MEGABYTE, this->compressed);
+    WriteBuffer<PathNode::rank_type> rank_buffer(rank_name, MEGABYTE, this->compressed);
     for(size_type i = 0; i < kmers.size(); i++)
     {
       path_buffer.push_back(PathNode(kmers[i], rank_buffer));
@@ -722,7 +1150,68 @@ PathGraph::PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_lab
     this->rank_counts.push_back(rank_buffer.size()); this->rank_count += rank_buffer.size();
     path_buffer.close(); rank_buffer.close();
   }
+  this->order = source.k();
+
+  // With multiple files, we need the labels of each file to convert the ranks.
+  sdsl::int_vector<0> file_labels;
+  if(this->files() > 1)
+  {
+    key_type max_label = 0;
+    for(size_type i = 0; i < keys.size(); i++) { max_label = std::max(max_label, Key::label(keys[i])); }
+    file_labels = sdsl::int_vector<0>(keys.size(), 0, bit_length(max_label));
+    for(size_type i = 0; i < keys.size(); i++) { file_labels[i] = Key::label(keys[i]); }
+  }
+
+  // Sort the keys and merge the ones sharing the same label.
+  removeDuplicates(from_nodes, true);
+  parallelQuickSort(keys.begin(), keys.end());
+  if(!(keys.empty()))
+  {
+    size_type i = 0;
+    for(size_type j = 1; j < keys.size(); j++)
+    {
+      if(Key::label(keys[i]) == Key::label(keys[j])) { keys[i] = Key::merge(keys[i], keys[j]); }
+      else { i++; keys[i] = keys[j]; }
+    }
+    keys.resize(i + 1);
+  }
+
+  // Replace the ranks among the labels in each file with the ranks among all labels.
+  if(this->files() > 1)
+  {
+    for(size_type file = 0; file < this->files(); file++)
+    {
+      std::vector<PathNode::rank_type> ranks(key_offsets[file + 1] - key_offsets[file]);
+      size_type current_rank = 0;
+      for(size_type i = 0; i < ranks.size(); i++)
+      {
+        while(Key::label(keys[current_rank]) < file_labels[key_offsets[file] + i]) { current_rank++; }
+        ranks[i] = current_rank;
+      }
+
+      std::string rank_name = TempFile::getName(PREFIX);
+      {
+        ReadBuffer<PathNode::rank_type> old_ranks;
+        old_ranks.open(this->rank_names[file], MEGABYTE, this->compressed);
+        WriteBuffer<PathNode::rank_type> rank_buffer(rank_name, MEGABYTE, this->compressed);
+        for(size_type i = 0; i < old_ranks.size(); i += 2)
+        {
+          old_ranks.seek(i);
+          rank_buffer.push_back(ranks[old_ranks[i]]);
+          rank_buffer.push_back(0); // Dummy value; the last label is not in use.
+        }
+        old_ranks.close(); rank_buffer.close();
+      }
+      TempFile::remove(this->rank_names[file]);
+      this->rank_names[file] = rank_name;
+    }
+  }
 
+  if(Verbosity::level >= Verbosity::BASIC)
+  {
+    std::cerr << "PathGraph::PathGraph(): " << keys.size() << " unique keys, "
+              << from_nodes.size() << " unique start nodes" << std::endl;
+  }
   if(Verbosity::level >= Verbosity::EXTENDED)
   {
     std::cerr << "PathGraph::PathGraph(): " << this->size() << " paths with "
@@ -732,11 +1221,11 @@ PathGraph::PathGraph(const InputGraph& source, sdsl::int_vector<0>& distinct_lab
   }
 }
 
-PathGraph::PathGraph(size_type file_count, size_type path_order, size_type steps) :
+PathGraph::PathGraph(size_type file_count, size_type path_order, size_type steps, bool compress) :
   path_names(file_count), rank_names(file_count), path_counts(file_count, 0), rank_counts(file_count, 0),
   path_count(0), rank_count(0), range_count(0), order(path_order), doubling_steps(steps),
   unique(0), redundant(0), unsorted(0), nondeterministic(0),
-  delete_files(true)
+  delete_files(true), compressed(compress)
 {
   for(size_type file = 0; file < this->files(); file++)
   {
@@ -751,7 +1240,7 @@ PathGraph::PathGraph(const std::string& path_name, const std::string& rank_name)
   this->order = 0; this->doubling_steps = 0;
   this->unique = 0; this->redundant = 0;
   this->unsorted = 0; this->nondeterministic = 0;
-  this->delete_files = false;
+  this->delete_files = false; this->compressed = false;
 
   this->path_names.push_back(path_name);
   std::ifstream path_file(path_name, std::ios_base::binary);
@@ -821,10 +1310,12 @@ PathGraph::swap(PathGraph& another)
   std::swap(this->redundant, another.redundant);
   std::swap(this->unsorted, another.unsorted);
   std::swap(this->nondeterministic, another.nondeterministic);
+
+  std::swap(this->compressed, another.compressed);
 }
 
 void
-PathGraph::open(std::ifstream& path_file, std::ifstream& rank_file, size_type file) const
+PathGraph::open(ElementFile<PathNode>& path_file, ElementFile<PathNode::rank_type>& rank_file, size_type file) const
 {
   if(file >= this->files())
   {
@@ -832,15 +1323,13 @@ PathGraph::open(std::ifstream& path_file, std::ifstream& rank_file, size_type fi
     std::exit(EXIT_FAILURE);
   }
 
-  path_file.open(this->path_names[file].c_str(), std::ios_base::binary);
-  if(!path_file)
+  if(!(path_file.open(this->path_names[file], this->compressed)))
   {
     std::cerr << "PathGraph::open(): Cannot open path file " << this->path_names[file] << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
-  rank_file.open(this->rank_names[file].c_str(), std::ios_base::binary);
-  if(!rank_file)
+  if(!(rank_file.open(this->rank_names[file], this->compressed)))
   {
     std::cerr << "PathGraph::open(): Cannot open rank file " << this->rank_names[file] << std::endl;
     std::exit(EXIT_FAILURE);
@@ -849,14 +1338,15 @@ PathGraph::open(std::ifstream& path_file, std::ifstream& rank_file, size_type fi
 
 //------------------------------------------------------------------------------
 
+template<class Merger>
 struct SameFromFile
 {
-  const PathGraphMerger& merger;
+  const Merger&          merger;
   node_type              from;
   size_type              file;
   bool                   same_from, same_file;
 
-  SameFromFile(const PathGraphMerger& source, range_type range) :
+  SameFromFile(const Merger& source, range_type range) :
     merger(source), from(source.buffer[range.first].node.from), file(source.buffer[range.first].file),
     same_from(true), same_file(true)
   {
@@ -880,51 +1370,436 @@ struct SameFromFile
   }
 };
 
-void
-PathGraph::prune(const LCP& lcp, size_type size_limit)
+template<class Merger>
+struct SameFromSet
 {
-  size_type old_path_count = this->size();
+  const Merger&          merger;
+  std::vector<node_type> nodes, buffer;
 
-  PathGraphMerger merger(*this, lcp);
-  PathGraphBuilder builder(this->files(), this->k(), this->step(), size_limit);
-  for(range_type range = merger.first(); !(merger.atEnd(range)); range = merger.next())
+  explicit SameFromSet(const Merger& source) :
+    merger(source)
   {
-    SameFromFile same_from(merger, range);
-    if(same_from.same_from)
-    {
-      if(same_from.same_file)
-      {
-        range = merger.extendRange(same_from);
-        merger.mergePathNodes();
-        builder.write(merger.buffer[range.second]);
-        builder.graph.unique++;
-      }
-      else
-      {
-        // FIXME Later: Write just one path per file.
-        for(size_type i = range.first; i <= range.second; i++)
-        {
-          merger.buffer[i].node.makeSorted();
-          builder.write(merger.buffer[i]);
-        }
-        builder.graph.redundant += Range::length(range);
-      }
-    }
-    else
+  }
+
+  inline void fromNodes(range_type range, std::vector<node_type>& to) const
+  {
+    to.clear();
+    node_type prev = ~(node_type)0;
+    for(size_type i = range.first; i <= range.second; i++)
     {
-      for(size_type i = range.first; i <= range.second; i++)
-      {
-        if(merger.buffer[i].node.sorted()) { builder.graph.nondeterministic++; }
-        else { builder.graph.unsorted++; }
-        builder.write(merger.buffer[i]);
-      }
+      node_type curr = this->merger.buffer[i].node.from;
+      if(curr != prev) { to.push_back(curr); prev = curr; }
     }
-    builder.graph.range_count++;
+    if(to.size() > 1) { removeDuplicates(to, false); }
   }
-  merger.close(); builder.close();
-  this->clear(); this->swap(builder.graph);
 
-  if(Verbosity::level >= Verbosity::EXTENDED)
+  inline bool operator() (range_type range)
+  {
+    this->fromNodes(range, this->buffer);
+
+    // Manual comparison guarantees using a single thread.
+    if(this->buffer.size() != this->nodes.size()) { return false; }
+    for(size_type i = 0; i < this->buffer.size(); i++)
+    {
+      if(this->buffer[i] != this->nodes[i]) { return false; }
+    }
+    return true;
+  }
+
+  inline void select(range_type range)
+  {
+    this->fromNodes(range, this->nodes);
+  }
+};
+
+//------------------------------------------------------------------------------
+
+// Use multiple threads for merging if there are at least this many paths per thread.
+const size_type PARALLEL_MERGE_SIZE = 4 * MEGABYTE;
+
+// Sample this many labels per interval from each file when choosing the splitters.
+const size_type MERGE_SAMPLES = 16;
+
+/*
+  Random access to the paths in a PathGraph. Used for choosing the splitters.
+*/
+struct PathGraphSearcher
+{
+  const PathGraph&                               graph;
+  std::vector<ElementFile<PathNode>>             path_files;
+  std::vector<ElementFile<PathNode::rank_type>>  rank_files;
+
+  explicit PathGraphSearcher(const PathGraph& path_graph);
+
+  template<size_type LENGTH>
+  void read(size_type file, size_type i, PriorityNode<LENGTH>& path);
+
+  // Returns the first path in the file that is not smaller than the splitter.
+  template<size_type LENGTH>
+  size_type lowerBound(size_type file, const PriorityNode<LENGTH>& splitter);
+};
+
+PathGraphSearcher::PathGraphSearcher(const PathGraph& path_graph) :
+  graph(path_graph), path_files(path_graph.files()), rank_files(path_graph.files())
+{
+  for(size_type file = 0; file < path_graph.files(); file++)
+  {
+    path_graph.open(this->path_files[file], this->rank_files[file], file);
+  }
+}
+
+template<size_type LENGTH>
+void
+PathGraphSearcher::read(size_type file, size_type i, PriorityNode<LENGTH>& path)
+{
+  path.file = file;
+  if(!(this->path_files[file].read(i, &(path.node))))
+  {
+    std::cerr << "PathGraphSearcher::read(): Unexpected EOF in " << this->graph.path_names[file] << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  if(!(this->rank_files[file].read(path.node.pointer(), path.label, path.node.ranks())))
+  {
+    std::cerr << "PathGraphSearcher::read(): Unexpected EOF in " << this->graph.rank_names[file] << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  path.node.setPointer(0);
+}
+
+template<size_type LENGTH>
+size_type
+PathGraphSearcher::lowerBound(size_type file, const PriorityNode<LENGTH>& splitter)
+{
+  size_type low = 0, high = this->graph.path_counts[file];
+  PriorityNode<LENGTH> path;
+  while(low < high)
+  {
+    size_type mid = low + (high - low) / 2;
+    this->read(file, mid, path);
+    if(path < splitter) { low = mid + 1; }
+    else { high = mid; }
+  }
+  return low;
+}
+
+/*
+  Partitions the merged stream into label intervals for parallel processing.
+
+  We sample splitter labels from the files and move each splitter forward to the next
+  safe boundary. A boundary between two ranges of paths with the same label is safe,
+  if the ranges have different sets of start nodes. Because both prune() and MergedGraph
+  only merge ranges with the same start nodes, a merged range can never span a safe
+  boundary. The first range after the boundary is then processed in the same way as in
+  a sequential merge.
+*/
+template<size_type LENGTH>
+std::vector<MergeInterval>
+mergeIntervals(const PathGraph& graph, const LCP& lcp)
+{
+  size_type threads = omp_get_max_threads();
+  size_type interval_count = std::min(threads, graph.size() / PARALLEL_MERGE_SIZE);
+  std::vector<MergeInterval> result(1, MergeInterval(graph));
+  if(interval_count <= 1) { return result; }
+
+  // Sample the labels. Each sample represents a number of paths in its file.
+  PathGraphSearcher searcher(graph);
+  std::vector<std::pair<PriorityNode<LENGTH>, double>> samples;
+  for(size_type file = 0; file < graph.files(); file++)
+  {
+    size_type sample_count = std::min(interval_count * MERGE_SAMPLES, graph.path_counts[file]);
+    for(size_type i = 0; i < sample_count; i++)
+    {
+      samples.push_back(std::make_pair(PriorityNode<LENGTH>(), graph.path_counts[file] / (double)sample_count));
+      searcher.read(file, (i * graph.path_counts[file]) / sample_count, samples.back().first);
+    }
+  }
+  std::sort(samples.begin(), samples.end(),
+    [](const std::pair<PriorityNode<LENGTH>, double>& a, const std::pair<PriorityNode<LENGTH>, double>& b)
+    {
+      return (a.first < b.first);
+    });
+
+  // Choose the splitters and find their offsets in the files.
+  std::vector<MergeInterval> boundaries;
+  double cumulative = 0.0;
+  for(size_type i = 0, next = 1; i < samples.size() && next < interval_count; i++)
+  {
+    cumulative += samples[i].second;
+    if(cumulative < (next * graph.size()) / (double)interval_count) { continue; }
+    MergeInterval boundary(graph);
+    for(size_type file = 0; file < graph.files(); file++)
+    {
+      boundary.offsets[file] = searcher.lowerBound(file, samples[i].first);
+      boundary.length -= boundary.offsets[file];
+    }
+    boundaries.push_back(boundary);
+    next++;
+  }
+  sdsl::util::clear(samples);
+
+  // Move each splitter forward to the next safe boundary.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(size_type i = 0; i < boundaries.size(); i++)
+  {
+    MergeInterval& boundary = boundaries[i];
+    PathGraphMerger<LENGTH> merger(graph, lcp, boundary, MEGABYTE / interval_count);
+    SameFromSet<PathGraphMerger<LENGTH>> from_set(merger);
+    std::vector<node_type> prev_from, curr_from;
+
+    range_type range = merger.first();
+    from_set.fromNodes(range, prev_from);
+    while(true)
+    {
+      for(size_type j = range.first; j <= range.second; j++)
+      {
+        boundary.offsets[merger.buffer[j].file]++; boundary.length--;
+      }
+      range = merger.next();
+      if(merger.atEnd(range)) { boundary.left_lcp = range_type(0, 0); break; }
+      from_set.fromNodes(range, curr_from);
+      if(curr_from != prev_from) { boundary.left_lcp = merger.ranges.front().left_lcp; break; }
+      prev_from.swap(curr_from);
+    }
+    merger.close();
+  }
+
+  // Convert the boundaries into nonempty intervals.
+  for(size_type i = 0; i < boundaries.size(); i++)
+  {
+    size_type length = result.back().length - boundaries[i].length;
+    if(length == 0 || boundaries[i].length == 0) { continue; }
+    result.back().length = length;
+    result.push_back(boundaries[i]);
+  }
+
+  if(Verbosity::level >= Verbosity::FULL)
+  {
+    std::cerr << "mergeIntervals(): Partitioned " << graph.size() << " paths into "
+              << result.size() << " intervals" << std::endl;
+  }
+  return result;
+}
+
+/*
+  Appends the elements of the block-compressed source file to the block-compressed target
+  file. The new blocks overwrite the old block index, and the combined index is written
+  after them.
+*/
+template<class Element, class Transformation>
+void
+appendBlocks(const std::string& source, const std::string& target, const Transformation& transform)
+{
+  std::ifstream in(source.c_str(), std::ios_base::binary);
+  BlockIndex source_index;
+  if(!in || !(source_index.read(in)))
+  {
+    std::cerr << "appendBlocks(): Cannot read input file " << source << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::fstream out(target.c_str(), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+  BlockIndex target_index;
+  if(!out || !(target_index.read(out)))
+  {
+    std::cerr << "appendBlocks(): Cannot read output file " << target << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  out.seekp(target_index.bytes(), std::ios_base::beg);
+  std::vector<Element> buffer;
+  for(size_type block = 0; block < source_index.blocks(); block++)
+  {
+    if(!readBlock(in, source_index, block, buffer))
+    {
+      std::cerr << "appendBlocks(): Invalid block " << block << " in " << source << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    for(size_type j = 0; j < buffer.size(); j++) { transform(buffer[j]); }
+    writeBlock(out, buffer.data(), buffer.size(), target_index);
+  }
+  target_index.write(out);
+  in.close(); out.close();
+}
+
+/*
+  Appends the elements of the source file to the target file. Each element is modified
+  with the transformation before writing it.
+*/
+template<class Element, class Transformation>
+void
+appendFile(const std::string& source, const std::string& target, const Transformation& transform,
+  bool compressed = false)
+{
+  if(compressed) { appendBlocks<Element>(source, target, transform); return; }
+
+  std::ifstream in(source.c_str(), std::ios_base::binary);
+  if(!in)
+  {
+    std::cerr << "appendFile(): Cannot open input file " << source << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::ofstream out(target.c_str(), std::ios_base::binary | std::ios_base::app);
+  if(!out)
+  {
+    std::cerr << "appendFile(): Cannot open output file " << target << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  size_type elements = fileSize(in) / sizeof(Element);
+  std::vector<Element> buffer;
+  for(size_type i = 0; i < elements; i += MEGABYTE)
+  {
+    buffer.resize(std::min(MEGABYTE, elements - i));
+    if(!DiskIO::read(in, buffer.data(), buffer.size()))
+    {
+      std::cerr << "appendFile(): Unexpected EOF in " << source << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    for(size_type j = 0; j < buffer.size(); j++) { transform(buffer[j]); }
+    DiskIO::write(out, buffer.data(), buffer.size());
+  }
+  in.close(); out.close();
+}
+
+struct NoTransformation
+{
+  template<class Element>
+  inline void operator() (Element&) const { }
+};
+
+// Moves the label pointers of the appended paths past the existing labels.
+struct LabelOffset
+{
+  size_type offset;
+
+  explicit LabelOffset(size_type _offset) : offset(_offset) { }
+  inline void operator() (PathNode& path) const { path.setPointer(path.pointer() + this->offset); }
+};
+
+// Moves the path identifiers of the appended start nodes past the existing paths.
+struct PathOffset
+{
+  size_type offset;
+
+  explicit PathOffset(size_type _offset) : offset(_offset) { }
+  inline void operator() (range_type& from) const { from.first += this->offset; }
+};
+
+/*
+  Appends the paths in source to target. The graphs must have the same number of files.
+*/
+void
+appendPathGraph(PathGraph& target, PathGraph& source)
+{
+  for(size_type file = 0; file < target.files(); file++)
+  {
+    appendFile<PathNode>(source.path_names[file], target.path_names[file],
+      LabelOffset(target.rank_counts[file]), target.compressed);
+    appendFile<PathNode::rank_type>(source.rank_names[file], target.rank_names[file],
+      NoTransformation(), target.compressed);
+    target.path_counts[file] += source.path_counts[file];
+    target.rank_counts[file] += source.rank_counts[file];
+  }
+  target.path_count += source.path_count; target.rank_count += source.rank_count;
+  target.range_count += source.range_count;
+
+  target.unique += source.unique; target.redundant += source.redundant;
+  target.unsorted += source.unsorted; target.nondeterministic += source.nondeterministic;
+  source.clear();
+}
+
+//------------------------------------------------------------------------------
+
+template<size_type LENGTH>
+void
+pruneInterval(PathGraphMerger<LENGTH>& merger, PathGraphBuilder& builder)
+{
+  for(range_type range = merger.first(); !(merger.atEnd(range)); range = merger.next())
+  {
+    SameFromFile<PathGraphMerger<LENGTH>> same_from(merger, range);
+    if(same_from.same_from)
+    {
+      if(same_from.same_file)
+      {
+        range = merger.extendRange(same_from);
+        merger.mergePathNodes();
+        builder.write(merger.buffer[range.second]);
+        builder.graph.unique++;
+      }
+      else
+      {
+        // FIXME Later: Write just one path per file.
+        for(size_type i = range.first; i <= range.second; i++)
+        {
+          merger.buffer[i].node.makeSorted();
+          builder.write(merger.buffer[i]);
+        }
+        builder.graph.redundant += Range::length(range);
+      }
+    }
+    else
+    {
+      for(size_type i = range.first; i <= range.second; i++)
+      {
+        if(merger.buffer[i].node.sorted()) { builder.graph.nondeterministic++; }
+        else { builder.graph.unsorted++; }
+        builder.write(merger.buffer[i]);
+      }
+    }
+    builder.graph.range_count++;
+  }
+}
+
+// Prunes each interval into a separate PathGraph and concatenates the results.
+struct PruneJob
+{
+  const PathGraph& graph;
+  const LCP&       lcp;
+  size_type        size_limit;
+  std::unique_ptr<PathGraphBuilder> result;
+
+  PruneJob(const PathGraph& source, const LCP& kmer_lcp, size_type limit) :
+    graph(source), lcp(kmer_lcp), size_limit(limit)
+  {
+  }
+
+  template<size_type LENGTH>
+  void run()
+  {
+    std::vector<MergeInterval> intervals = mergeIntervals<LENGTH>(this->graph, this->lcp);
+    std::vector<std::unique_ptr<PathGraphBuilder>> builders(intervals.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(size_type i = 0; i < intervals.size(); i++)
+    {
+      builders[i].reset(new PathGraphBuilder(this->graph.files(), this->graph.k(), this->graph.step(),
+        this->size_limit, this->graph.compressed));
+      PathGraphMerger<LENGTH> merger(this->graph, this->lcp, intervals[i], MEGABYTE / intervals.size());
+      pruneInterval(merger, *(builders[i]));
+      merger.close(); builders[i]->close();
+    }
+    for(size_type i = 1; i < builders.size(); i++)
+    {
+      appendPathGraph(builders[0]->graph, builders[i]->graph);
+      builders[i].reset();
+    }
+    this->result.swap(builders[0]);
+  }
+};
+
+void
+PathGraph::prune(const LCP& lcp, size_type size_limit)
+{
+  size_type old_path_count = this->size();
+
+  PruneJob job(*this, lcp, size_limit);
+  withLabelLength(this->step(), job);
+  if(job.result->graph.bytes() > size_limit)
+  {
+    std::cerr << "PathGraph::prune(): Size limit exceeded, construction aborted" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  this->clear(); this->swap(job.result->graph);
+
+  if(Verbosity::level >= Verbosity::EXTENDED)
   {
     std::cerr << "PathGraph::prune(): " << old_path_count << " -> " << this->size() << " paths ("
               << this->ranges() << " ranges)" << std::endl;
@@ -940,66 +1815,183 @@ PathGraph::prune(const LCP& lcp, size_type size_limit)
 
 //------------------------------------------------------------------------------
 
+// Join partitions should have at most this many paths to fit in cache.
+const size_type JOIN_PARTITION_SIZE = 16 * KILOBYTE;
+
+// Files larger than this are partitioned on disk before the join.
+const size_type JOIN_BUFFER_SIZE = 8 * GIGABYTE;
+
+inline size_type
+joinPartition(node_type node, size_type partitions)
+{
+  return wang_hash_64(node) & (partitions - 1);
+}
+
+/*
+  Sorts the (node, path) pairs by join partition. Partition p will be in
+  keys[offsets[p], offsets[p + 1]).
+*/
 void
-PathGraph::extend(size_type size_limit)
+partitionJoinKeys(std::vector<range_type>& keys, std::vector<size_type>& offsets, size_type partitions)
 {
-  size_type old_path_count = this->size();
+  offsets = std::vector<size_type>(partitions + 1, 0);
+  for(size_type i = 0; i < keys.size(); i++) { offsets[joinPartition(keys[i].first, partitions) + 1]++; }
+  for(size_type i = 1; i <= partitions; i++) { offsets[i] += offsets[i - 1]; }
 
-  PathGraphBuilder builder(this->files(), 2 * this->k(), this->step() + 1, size_limit);
-  for(size_type file = 0; file < this->files(); file++)
+  std::vector<range_type> result(keys.size());
+  std::vector<size_type> tails(offsets.begin(), offsets.end() - 1);
+  for(size_type i = 0; i < keys.size(); i++)
   {
-    // Read the current file.
-    std::vector<PathNode> paths;
-    std::vector<PathNode::rank_type> labels;
-    this->read(paths, labels, file);
+    result[tails[joinPartition(keys[i].first, partitions)]++] = keys[i];
+  }
+  keys.swap(result);
+}
 
-    // Initialization.
-    PathFromComparator from_c;  // Sort the paths by from.
-    parallelQuickSort(paths.begin(), paths.end(), from_c);
-    ValueIndex<PathNode, FromGetter> from_index(paths);
-    size_type threads = omp_get_max_threads();
+/*
+  Creates the next generation from paths[0, left_count). Sorted paths are copied, while
+  unsorted paths are joined with the paths in paths[right_start, paths.size()) that start
+  where they end. The join is hash-partitioned by the join node into cache-sized
+  partitions that are processed in parallel.
+*/
+void
+extendPaths(const std::vector<PathNode>& paths, const std::vector<PathNode::rank_type>& labels,
+  size_type left_count, size_type right_start, PathGraphBuilder& builder, size_type file)
+{
+  size_type threads = omp_get_max_threads();
 
-    // Create thread-specific buffers.
-    std::vector<std::vector<PathNode>> temp_nodes(threads);
-    std::vector<std::vector<PathNode::rank_type>> temp_labels(threads);
-    for(size_type thread = 0; thread < threads; thread++)
+  // Create thread-specific buffers.
+  std::vector<std::vector<PathNode>> temp_nodes(threads);
+  std::vector<std::vector<PathNode::rank_type>> temp_labels(threads);
+  for(size_type thread = 0; thread < threads; thread++)
+  {
+    temp_nodes[thread].reserve(PathGraphBuilder::WRITE_BUFFER_SIZE);
+    temp_labels[thread].reserve(((1 << builder.graph.step()) + 1) * PathGraphBuilder::WRITE_BUFFER_SIZE);
+  }
+
+  // Copy the sorted paths and collect the join keys.
+  std::vector<range_type> left_keys, right_keys;
+  size_type chunk_size = getChunkSize(left_count, MEGABYTE);
+  #pragma omp parallel for schedule(dynamic, chunk_size)
+  for(size_type i = 0; i < left_count; i++)
+  {
+    if(!(paths[i].sorted())) { continue; }
+    size_type thread = omp_get_thread_num();
+    temp_nodes[thread].push_back(PathNode(paths[i], labels, temp_labels[thread]));
+    if(temp_nodes[thread].size() >= PathGraphBuilder::WRITE_BUFFER_SIZE)
     {
-      temp_nodes[thread].reserve(PathGraphBuilder::WRITE_BUFFER_SIZE);
-      temp_labels[thread].reserve(((1 << builder.graph.step()) + 1) * PathGraphBuilder::WRITE_BUFFER_SIZE);
+      builder.write(temp_nodes[thread], temp_labels[thread], file);
     }
+  }
+  for(size_type i = 0; i < left_count; i++)
+  {
+    if(!(paths[i].sorted())) { left_keys.push_back(range_type(paths[i].to, i)); }
+  }
+  for(size_type i = right_start; i < paths.size(); i++)
+  {
+    right_keys.push_back(range_type(paths[i].from, i));
+  }
 
-    // Create the next generation.
-    size_type chunk_size = getChunkSize(paths.size(), MEGABYTE);
-    #pragma omp parallel for schedule(dynamic, chunk_size)
-    for(size_type i = 0; i < paths.size(); i++)
+  // Partition the keys.
+  size_type partitions = 1;
+  while(partitions * JOIN_PARTITION_SIZE < right_keys.size()) { partitions *= 2; }
+  std::vector<size_type> left_offsets, right_offsets;
+  partitionJoinKeys(left_keys, left_offsets, partitions);
+  partitionJoinKeys(right_keys, right_offsets, partitions);
+
+  // Join the partitions.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(size_type partition = 0; partition < partitions; partition++)
+  {
+    if(left_offsets[partition] == left_offsets[partition + 1]) { continue; }
+    size_type thread = omp_get_thread_num();
+    auto right_begin = right_keys.begin() + right_offsets[partition];
+    auto right_end = right_keys.begin() + right_offsets[partition + 1];
+    std::sort(right_begin, right_end);
+    for(size_type i = left_offsets[partition]; i < left_offsets[partition + 1]; i++)
     {
-      size_type thread = omp_get_thread_num();
-      if(paths[i].sorted())
+      const PathNode& left = paths[left_keys[i].second];
+      auto iter = std::lower_bound(right_begin, right_end, range_type(left_keys[i].first, 0));
+      for(; iter != right_end && iter->first == left_keys[i].first; ++iter)
       {
-        temp_nodes[thread].push_back(PathNode(paths[i], labels, temp_labels[thread]));
+        temp_nodes[thread].push_back(PathNode(left, paths[iter->second], labels, temp_labels[thread]));
         if(temp_nodes[thread].size() >= PathGraphBuilder::WRITE_BUFFER_SIZE)
         {
           builder.write(temp_nodes[thread], temp_labels[thread], file);
         }
       }
-      else
+    }
+  }
+  for(size_type thread = 0; thread < threads; thread++)
+  {
+    builder.write(temp_nodes[thread], temp_labels[thread], file);
+  }
+}
+
+/*
+  Out-of-core join partitions. Partition p consists of the paths to extend in part 2p
+  and the paths they may be joined with in part 2p + 1. Sorted paths are not extended,
+  so any partition will do for them.
+*/
+struct JoinTargets
+{
+  size_type partitions;
+
+  explicit JoinTargets(size_type n) : partitions(n) { }
+
+  inline range_type operator() (const PathNode& path, PathNode::rank_type) const
+  {
+    size_type left = joinPartition((path.sorted() ? path.from : path.to), this->partitions);
+    return range_type(2 * left, 2 * joinPartition(path.from, this->partitions) + 1);
+  }
+};
+
+void
+PathGraph::extend(size_type size_limit)
+{
+  size_type old_path_count = this->size();
+
+  PathGraphBuilder builder(this->files(), 2 * this->k(), this->step() + 1, size_limit, this->compressed);
+  for(size_type file = 0; file < this->files(); file++)
+  {
+    size_type file_bytes = this->path_counts[file] * sizeof(PathNode) +
+                           this->rank_counts[file] * sizeof(PathNode::rank_type);
+    if(file_bytes <= JOIN_BUFFER_SIZE)
+    {
+      std::vector<PathNode> paths;
+      std::vector<PathNode::rank_type> labels;
+      this->read(paths, labels, file);
+      extendPaths(paths, labels, paths.size(), 0, builder, file);
+    }
+    else
+    {
+      // Each partition contains two copies of about 1 / partitions of the file.
+      size_type partitions = 1;
+      while(partitions * JOIN_BUFFER_SIZE < 2 * file_bytes) { partitions *= 2; }
+      PathGraph parts(2 * partitions, this->k(), this->step());
+      partitionPaths(*this, file, parts, JoinTargets(partitions), JOIN_BUFFER_SIZE / 2);
+      for(size_type partition = 0; partition < partitions; partition++)
       {
-        size_type first = from_index.find(paths[i].to);
-        for(size_type j = first; j < paths.size() && paths[j].from == paths[i].to; j++)
+        size_type left = 2 * partition, right = 2 * partition + 1;
+        std::vector<PathNode> paths, right_paths;
+        std::vector<PathNode::rank_type> labels, right_labels;
+        if(parts.path_counts[left] > 0) { parts.read(paths, labels, left); }
+        if(parts.path_counts[right] > 0) { parts.read(right_paths, right_labels, right); }
+        TempFile::remove(parts.path_names[left]); TempFile::remove(parts.rank_names[left]);
+        TempFile::remove(parts.path_names[right]); TempFile::remove(parts.rank_names[right]);
+        if(paths.empty()) { continue; }
+
+        // Append the paths to join with after the paths to extend.
+        size_type left_count = paths.size();
+        for(size_type i = 0; i < right_paths.size(); i++)
         {
-          temp_nodes[thread].push_back(PathNode(paths[i], paths[j], labels, temp_labels[thread]));
-          if(temp_nodes[thread].size() >= PathGraphBuilder::WRITE_BUFFER_SIZE)
-          {
-            builder.write(temp_nodes[thread], temp_labels[thread], file);
-          }
+          right_paths[i].setPointer(right_paths[i].pointer() + labels.size());
         }
+        paths.insert(paths.end(), right_paths.begin(), right_paths.end());
+        labels.insert(labels.end(), right_labels.begin(), right_labels.end());
+        sdsl::util::clear(right_paths); sdsl::util::clear(right_labels);
+        extendPaths(paths, labels, left_count, left_count, builder, file);
       }
     }
-    for(size_type thread = 0; thread < threads; thread++)
-    {
-      builder.write(temp_nodes[thread], temp_labels[thread], file);
-    }
-    sdsl::util::clear(paths); sdsl::util::clear(labels);
 
     if(Verbosity::level >= Verbosity::FULL)
     {
@@ -1078,14 +2070,15 @@ PathGraph::read(std::vector<PathNode>& paths, std::vector<PathNode::rank_type>&
   paths.resize(this->path_counts[file]);
   labels.resize(this->rank_counts[file]);
 
-  std::ifstream path_file, rank_file;
+  ElementFile<PathNode> path_file;
+  ElementFile<PathNode::rank_type> rank_file;
   this->open(path_file, rank_file, file);
-  if(!DiskIO::read(path_file, paths.data(), this->path_counts[file]))
+  if(!(path_file.read(0, paths.data(), this->path_counts[file])))
   {
     std::cerr << "PathGraph::read(): Unexpected EOF in " << this->path_names[file] << std::endl;
     std::exit(EXIT_FAILURE);
   }
-  if(!DiskIO::read(rank_file, labels.data(), this->rank_counts[file]))
+  if(!(rank_file.read(0, labels.data(), this->rank_counts[file])))
   {
     std::cerr << "PathGraph::read(): Unexpected EOF in " << this->rank_names[file] << std::endl;
     std::exit(EXIT_FAILURE);
@@ -1101,58 +2094,18 @@ PathGraph::read(std::vector<PathNode>& paths, std::vector<PathNode::rank_type>&
 
 //------------------------------------------------------------------------------
 
-struct SameFromSet
-{
-  const PathGraphMerger& merger;
-  std::vector<node_type> nodes, buffer;
-
-  SameFromSet(const PathGraphMerger& source) :
-    merger(source)
-  {
-  }
-
-  inline void fromNodes(range_type range, std::vector<node_type>& to) const
-  {
-    to.clear();
-    node_type prev = ~(node_type)0;
-    for(size_type i = range.first; i <= range.second; i++)
-    {
-      node_type curr = this->merger.buffer[i].node.from;
-      if(curr != prev) { to.push_back(curr); prev = curr; }
-    }
-    if(to.size() > 1) { removeDuplicates(to, false); }
-  }
-
-  inline bool operator() (range_type range)
-  {
-    this->fromNodes(range, this->buffer);
-
-    // Manual comparison guarantees using a single thread.
-    if(this->buffer.size() != this->nodes.size()) { return false; }
-    for(size_type i = 0; i < this->buffer.size(); i++)
-    {
-      if(this->buffer[i] != this->nodes[i]) { return false; }
-    }
-    return true;
-  }
-
-  inline void select(range_type range)
-  {
-    this->fromNodes(range, this->nodes);
-  }
-};
-
-MergedGraph::MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, const LCP& kmer_lcp, size_type size_limit) :
-  path_name(TempFile::getName(PREFIX)), rank_name(TempFile::getName(PREFIX)),
-  from_name(TempFile::getName(PREFIX)), lcp_name(TempFile::getName(PREFIX)),
-  path_count(0), rank_count(0), from_count(0),
-  order(source.k()),
-  next(mapper.alpha.sigma + 1, 0), next_from(mapper.alpha.sigma + 1, 0)
+/*
+  Merges the paths in the interval into the graph. Returns the number of comp values
+  for which next[comp] has been transformed into a path rank.
+*/
+template<size_type LENGTH>
+size_type
+mergeInterval(MergedGraph& graph, PathGraphMerger<LENGTH>& merger, const DeBruijnGraph& mapper, size_type size_limit)
 {
-  WriteBuffer<PathNode>            path_file(this->path_name);
-  WriteBuffer<PathNode::rank_type> rank_file(this->rank_name);
-  WriteBuffer<range_type>          from_file(this->from_name);
-  WriteBuffer<uint8_t>             lcp_file(this->lcp_name);
+  WriteBuffer<PathNode>              path_file(graph.path_name);
+  WriteBuffer<PathNode::rank_type>   rank_file(graph.rank_name);
+  WriteBuffer<range_type>            from_file(graph.from_name);
+  WriteBuffer<MergedGraph::lcp_type> lcp_file(graph.lcp_name);
 
   /*
      Initialize next[comp] to be the the rank of the first kmer starting with
@@ -1161,13 +2114,12 @@ MergedGraph::MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, c
   */
   for(size_type comp = 0; comp < mapper.alpha.sigma; comp++)
   {
-    this->next[comp] = mapper.charRange(comp).first;
+    graph.next[comp] = mapper.charRange(comp).first;
   }
-  this->next[mapper.alpha.sigma] = ~(size_type)0;
-  this->next_from[mapper.alpha.sigma] = ~(size_type)0;
+  graph.next[mapper.alpha.sigma] = ~(size_type)0;
+  graph.next_from[mapper.alpha.sigma] = ~(size_type)0;
 
-  PathGraphMerger merger(source, kmer_lcp);
-  SameFromSet same_from_set(merger);
+  SameFromSet<PathGraphMerger<LENGTH>> same_from_set(merger);
   size_type curr_comp = 0;  // Used to transform next.
 
   size_type bytes = 0;
@@ -1177,11 +2129,11 @@ MergedGraph::MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, c
     same_from_set.select(range);
     range = merger.extendRange(same_from_set);
     merger.mergePathNodes();
-    PriorityNode& curr = merger.buffer[range.second];
+    PriorityNode<LENGTH>& curr = merger.buffer[range.second];
     curr.node.from = same_from_set.nodes[0];
 
     // Write the actual data
-    bytes += curr.node.bytes() + (same_from_set.nodes.size() - 1) * sizeof(range_type) + 1;
+    bytes += curr.node.bytes() + (same_from_set.nodes.size() - 1) * sizeof(range_type) + sizeof(MergedGraph::lcp_type);
     if(bytes > size_limit)
     {
       std::cerr << "MergedGraph::MergedGraph(): Size limit exceeded, construction aborted" << std::endl;
@@ -1190,24 +2142,97 @@ MergedGraph::MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, c
     writePath(curr.node, curr.label, path_file, rank_file);
     for(size_type i = 1; i < same_from_set.nodes.size(); i++)
     {
-      from_file.push_back(range_type(this->path_count, same_from_set.nodes[i]));
+      from_file.push_back(range_type(graph.path_count, same_from_set.nodes[i]));
     }
     lcp_file.push_back(path_lcp.first * mapper.order() + path_lcp.second);
 
     // Update the counts and the pointers to paths starting with each comp value.
-    while(curr.firstLabel(0) >= this->next[curr_comp])
+    while(curr.firstLabel(0) >= graph.next[curr_comp])
     {
-      this->next[curr_comp] = this->path_count;
-      this->next_from[curr_comp] = this->from_count;
+      graph.next[curr_comp] = graph.path_count;
+      graph.next_from[curr_comp] = graph.from_count;
       curr_comp++;
     }
-    this->path_count++;
-    this->rank_count += curr.node.ranks();
-    this->from_count += same_from_set.nodes.size() - 1;
+    graph.path_count++;
+    graph.rank_count += curr.node.ranks();
+    graph.from_count += same_from_set.nodes.size() - 1;
   }
-  merger.close();
   path_file.close(); rank_file.close(); from_file.close(); lcp_file.close();
 
+  return curr_comp;
+}
+
+// Merges each interval into a separate graph. The first part is the graph itself.
+struct MergeJob
+{
+  MergedGraph&          graph;
+  const PathGraph&      source;
+  const DeBruijnGraph&  mapper;
+  const LCP&            lcp;
+  size_type             size_limit;
+
+  std::vector<std::unique_ptr<MergedGraph>> parts;
+  std::vector<size_type>                    comps;
+
+  MergeJob(MergedGraph& target, const PathGraph& path_graph, const DeBruijnGraph& kmer_mapper,
+    const LCP& kmer_lcp, size_type limit) :
+    graph(target), source(path_graph), mapper(kmer_mapper), lcp(kmer_lcp), size_limit(limit)
+  {
+  }
+
+  template<size_type LENGTH>
+  void run()
+  {
+    std::vector<MergeInterval> intervals = mergeIntervals<LENGTH>(this->source, this->lcp);
+    this->parts.resize(intervals.size());
+    this->comps = std::vector<size_type>(intervals.size(), 0);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(size_type i = 0; i < intervals.size(); i++)
+    {
+      MergedGraph* part = &(this->graph);
+      if(i > 0)
+      {
+        this->parts[i].reset(new MergedGraph(this->source.k(), this->source.step(), this->mapper.alpha.sigma));
+        part = this->parts[i].get();
+      }
+      PathGraphMerger<LENGTH> merger(this->source, this->lcp, intervals[i], MEGABYTE / intervals.size());
+      this->comps[i] = mergeInterval(*part, merger, this->mapper, this->size_limit);
+      merger.close();
+    }
+  }
+};
+
+MergedGraph::MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, const LCP& kmer_lcp, size_type size_limit) :
+  MergedGraph(source.k(), source.step(), mapper.alpha.sigma)
+{
+  // Merge each interval into a separate graph and concatenate the results.
+  MergeJob job(*this, source, mapper, kmer_lcp, size_limit);
+  withLabelLength(source.step(), job);
+  std::vector<std::unique_ptr<MergedGraph>>& parts = job.parts;
+  std::vector<size_type>& comps = job.comps;
+  for(size_type i = 1, curr_comp = comps[0]; i < parts.size(); i++)
+  {
+    MergedGraph& part = *(parts[i]);
+    for(; curr_comp < comps[i]; curr_comp++)
+    {
+      this->next[curr_comp] = this->path_count + part.next[curr_comp];
+      this->next_from[curr_comp] = this->from_count + part.next_from[curr_comp];
+    }
+    appendFile<PathNode>(part.path_name, this->path_name, LabelOffset(this->rank_count));
+    appendFile<PathNode::rank_type>(part.rank_name, this->rank_name, NoTransformation());
+    appendFile<range_type>(part.from_name, this->from_name, PathOffset(this->path_count));
+    appendFile<lcp_type>(part.lcp_name, this->lcp_name, NoTransformation());
+    this->path_count += part.path_count;
+    this->rank_count += part.rank_count;
+    this->from_count += part.from_count;
+    parts[i].reset();
+  }
+  if(this->bytes() > size_limit)
+  {
+    std::cerr << "MergedGraph::MergedGraph(): Size limit exceeded, construction aborted" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
   if(Verbosity::level >= Verbosity::EXTENDED)
   {
     std::cerr << "MergedGraph::MergedGraph(): " << this->size() << " paths with "
@@ -1216,6 +2241,15 @@ MergedGraph::MergedGraph(const PathGraph& source, const DeBruijnGraph& mapper, c
   }
 }
 
+MergedGraph::MergedGraph(size_type path_order, size_type steps, size_type sigma) :
+  path_name(TempFile::getName(PREFIX)), rank_name(TempFile::getName(PREFIX)),
+  from_name(TempFile::getName(PREFIX)), lcp_name(TempFile::getName(PREFIX)),
+  path_count(0), rank_count(0), from_count(0),
+  order(path_order), doubling_steps(steps),
+  next(sigma + 1, 0), next_from(sigma + 1, 0)
+{
+}
+
 MergedGraph::~MergedGraph()
 {
   this->clear();
@@ -1230,7 +2264,7 @@ MergedGraph::clear()
   TempFile::remove(this->lcp_name);
 
   this->path_count = 0; this->rank_count = 0; this->from_count = 0;
-  this->order = 0;
+  this->order = 0; this->doubling_steps = 0;
 
   for(size_type i = 0; i < this->next.size(); i++) { this->next[i] = 0; }
   for(size_type i = 0; i < this->next_from.size(); i++) { this->next_from[i] = 0; }
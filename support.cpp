@@ -45,6 +45,18 @@ constexpr Alphabet::size_type Alphabet::SOURCE_COMP;
 constexpr Alphabet::size_type Alphabet::SINK_COMP;
 constexpr Alphabet::size_type Alphabet::FAST_CHARS;
 
+constexpr PackedBWT::size_type PackedBWT::CHARS;
+constexpr PackedBWT::size_type PackedBWT::BLOCK_SIZE;
+constexpr PackedBWT::size_type PackedBWT::BLOCK_WORDS;
+constexpr PackedBWT::size_type PackedBWT::ALIGNMENT;
+
+constexpr SparseBWT::size_type SparseBWT::BLOCK_SIZE;
+
+constexpr RankBitVector::size_type RankBitVector::BLOCK_WORDS;
+constexpr RankBitVector::size_type RankBitVector::DATA_WORDS;
+constexpr RankBitVector::size_type RankBitVector::BLOCK_BITS;
+constexpr RankBitVector::size_type RankBitVector::ALIGNMENT;
+
 constexpr size_type Key::GCSA_CHAR_WIDTH;
 constexpr key_type Key::CHAR_MASK;
 constexpr size_type Key::MAX_LENGTH;
@@ -93,7 +105,9 @@ const sdsl::int_vector<8> Alphabet::DEFAULT_COMP2CHAR = { '$', 'A', 'C', 'G', 'T
 
 ConstructionParameters::ConstructionParameters() :
   doubling_steps(DOUBLING_STEPS), size_limit(SIZE_LIMIT * GIGABYTE),
-  sample_period(SAMPLE_PERIOD), lcp_branching(LCP_BRANCHING)
+  sample_period(SAMPLE_PERIOD), lcp_branching(LCP_BRANCHING),
+  packed_bwt(false), run_length_bwt(false), combined_sparse(false), mappable(false), compress_temp(false),
+  rank_vectors(false)
 {
 }
 
@@ -134,6 +148,44 @@ ConstructionParameters::setLCPBranching(size_type factor)
   this->lcp_branching = std::max((size_type)2, factor);
 }
 
+void
+ConstructionParameters::setPackedBWT(bool packed)
+{
+  this->packed_bwt = packed;
+  if(packed) { this->run_length_bwt = false; }
+}
+
+void
+ConstructionParameters::setRunLengthBWT(bool run_length)
+{
+  this->run_length_bwt = run_length;
+  if(run_length) { this->packed_bwt = false; }
+}
+
+void
+ConstructionParameters::setCombinedSparse(bool combined)
+{
+  this->combined_sparse = combined;
+}
+
+void
+ConstructionParameters::setMappable(bool mappable)
+{
+  this->mappable = mappable;
+}
+
+void
+ConstructionParameters::setCompressTemp(bool compress)
+{
+  this->compress_temp = compress;
+}
+
+void
+ConstructionParameters::setRankVectors(bool rank_vectors)
+{
+  this->rank_vectors = rank_vectors;
+}
+
 //------------------------------------------------------------------------------
 
 Alphabet::Alphabet() :
@@ -521,6 +573,649 @@ SadaSparse::setVectors()
 
 //------------------------------------------------------------------------------
 
+PackedBWT::PackedBWT() :
+  elements(0), block_count(0), data(), first_block(nullptr)
+{
+}
+
+PackedBWT::PackedBWT(const PackedBWT& source)
+{
+  this->copy(source);
+}
+
+PackedBWT::PackedBWT(PackedBWT&& source)
+{
+  *this = std::move(source);
+}
+
+PackedBWT::~PackedBWT()
+{
+}
+
+PackedBWT::PackedBWT(const std::vector<sdsl::bit_vector>& bwt, size_type fast_chars)
+{
+  fast_chars = std::min(fast_chars, std::min(CHARS, (size_type)(bwt.size() - 1)));
+  std::uint64_t* block = this->allocate(bwt[1].size());
+  std::uint64_t ranks[CHARS] = {};
+  for(size_type i = 0; i < this->blocks(); i++, block += BLOCK_WORDS)
+  {
+    size_type start = i * BLOCK_SIZE;
+    size_type length = (start < this->size() ? std::min(BLOCK_SIZE, this->size() - start) : 0);
+    for(size_type comp = 1; comp <= CHARS; comp++)
+    {
+      block[comp - 1] = ranks[comp - 1];
+      if(comp <= fast_chars && length > 0)
+      {
+        block[CHARS + comp - 1] = bwt[comp].get_int(start, length);
+        ranks[comp - 1] += sdsl::bits::cnt(block[CHARS + comp - 1]);
+      }
+    }
+  }
+}
+
+void
+PackedBWT::swap(PackedBWT& another)
+{
+  if(this != &another)
+  {
+    std::swap(this->elements, another.elements);
+    std::swap(this->block_count, another.block_count);
+    this->data.swap(another.data);
+    std::swap(this->first_block, another.first_block);
+  }
+}
+
+PackedBWT&
+PackedBWT::operator=(const PackedBWT& source)
+{
+  if(this != &source) { this->copy(source); }
+  return *this;
+}
+
+PackedBWT&
+PackedBWT::operator=(PackedBWT&& source)
+{
+  if(this != &source)
+  {
+    this->elements = source.elements;
+    this->block_count = source.block_count;
+    this->data = std::move(source.data);
+    this->first_block = source.first_block;
+    source.elements = source.block_count = 0; source.first_block = nullptr;
+  }
+  return *this;
+}
+
+PackedBWT::size_type
+PackedBWT::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string name,
+                     size_type position, size_type alignment) const
+{
+  sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+  size_type written_bytes = 0;
+
+  written_bytes += sdsl::write_member(this->elements, out, child, "elements");
+  written_bytes += sdsl::write_member(this->block_count, out, child, "block_count");
+  written_bytes += serializeWords(this->first_block, this->blocks() * BLOCK_WORDS, out,
+                                  position + written_bytes, child, "blocks", alignment);
+
+  sdsl::structure_tree::add_size(child, written_bytes);
+  return written_bytes;
+}
+
+void
+PackedBWT::load(std::istream& in, const MappedFile* mapping)
+{
+  size_type n = 0, blocks = 0;
+  sdsl::read_member(n, in);
+  sdsl::read_member(blocks, in);
+  size_type words = loadWordCount(in);
+  if(blocks != n / BLOCK_SIZE + 1 || words != blocks * BLOCK_WORDS)
+  {
+    std::cerr << "PackedBWT::load(): Invalid block count " << blocks << " for " << n << " positions" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  const std::uint64_t* mapped = (mapping != nullptr ? mapWords(in, *mapping, words) : nullptr);
+  if(mapped != nullptr)
+  {
+    this->data = WordBuffer();
+    this->elements = n; this->block_count = blocks;
+    this->first_block = mapped;
+  }
+  else
+  {
+    loadWords(in, this->allocate(n), words);
+  }
+}
+
+void
+PackedBWT::copy(const PackedBWT& source)
+{
+  std::copy(source.first_block, source.first_block + source.blocks() * BLOCK_WORDS, this->allocate(source.size()));
+}
+
+std::uint64_t*
+PackedBWT::allocate(size_type n)
+{
+  // There is always a block after the last position to support rank(n, comp).
+  this->elements = n;
+  this->block_count = n / BLOCK_SIZE + 1;
+  this->data = WordBuffer(this->block_count * BLOCK_WORDS);
+  this->first_block = this->data.data();
+  return this->data.data();
+}
+
+//------------------------------------------------------------------------------
+
+RunLengthVector::RunLengthVector()
+{
+}
+
+RunLengthVector::RunLengthVector(const RunLengthVector& source)
+{
+  this->copy(source);
+}
+
+RunLengthVector::RunLengthVector(RunLengthVector&& source)
+{
+  *this = std::move(source);
+}
+
+RunLengthVector::~RunLengthVector()
+{
+}
+
+RunLengthVector::RunLengthVector(const sdsl::bit_vector& source)
+{
+  size_type run_count = 0, ones = 0;
+  for(size_type i = 0; i < source.size(); i++)
+  {
+    if(source[i])
+    {
+      if(i == 0 || !source[i - 1]) { run_count++; }
+      ones++;
+    }
+  }
+
+  sdsl::sd_vector_builder starts(source.size(), run_count), lengths(ones, run_count);
+  for(size_type i = 0, tail = 0; i < source.size(); i++)
+  {
+    if(!source[i]) { continue; }
+    if(i == 0 || !source[i - 1]) { starts.set(i); }
+    tail++;
+    if(i + 1 >= source.size() || !source[i + 1]) { lengths.set(tail - 1); }
+  }
+  this->run_starts = sd_vector(starts);
+  this->run_lengths = sd_vector(lengths);
+
+  sdsl::util::init_support(this->start_rank, &(this->run_starts));
+  sdsl::util::init_support(this->start_select, &(this->run_starts));
+  sdsl::util::init_support(this->length_select, &(this->run_lengths));
+}
+
+void
+RunLengthVector::swap(RunLengthVector& another)
+{
+  if(this != &another)
+  {
+    this->run_starts.swap(another.run_starts);
+    sdsl::util::swap_support(this->start_rank, another.start_rank,
+      &(this->run_starts), &(another.run_starts));
+    sdsl::util::swap_support(this->start_select, another.start_select,
+      &(this->run_starts), &(another.run_starts));
+
+    this->run_lengths.swap(another.run_lengths);
+    sdsl::util::swap_support(this->length_select, another.length_select,
+      &(this->run_lengths), &(another.run_lengths));
+  }
+}
+
+RunLengthVector&
+RunLengthVector::operator=(const RunLengthVector& source)
+{
+  if(this != &source) { this->copy(source); }
+  return *this;
+}
+
+RunLengthVector&
+RunLengthVector::operator=(RunLengthVector&& source)
+{
+  if(this != &source)
+  {
+    this->run_starts = std::move(source.run_starts);
+    this->start_rank = std::move(source.start_rank);
+    this->start_select = std::move(source.start_select);
+
+    this->run_lengths = std::move(source.run_lengths);
+    this->length_select = std::move(source.length_select);
+
+    this->setVectors();
+  }
+  return *this;
+}
+
+RunLengthVector::size_type
+RunLengthVector::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string name) const
+{
+  sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+  size_type written_bytes = 0;
+
+  written_bytes += this->run_starts.serialize(out, child, "run_starts");
+  written_bytes += this->start_rank.serialize(out, child, "start_rank");
+  written_bytes += this->start_select.serialize(out, child, "start_select");
+
+  written_bytes += this->run_lengths.serialize(out, child, "run_lengths");
+  written_bytes += this->length_select.serialize(out, child, "length_select");
+
+  sdsl::structure_tree::add_size(child, written_bytes);
+  return written_bytes;
+}
+
+void
+RunLengthVector::load(std::istream& in)
+{
+  this->run_starts.load(in);
+  this->start_rank.load(in, &(this->run_starts));
+  this->start_select.load(in, &(this->run_starts));
+
+  this->run_lengths.load(in);
+  this->length_select.load(in, &(this->run_lengths));
+}
+
+void
+RunLengthVector::copy(const RunLengthVector& source)
+{
+  this->run_starts = source.run_starts;
+  this->start_rank = source.start_rank;
+  this->start_select = source.start_select;
+
+  this->run_lengths = source.run_lengths;
+  this->length_select = source.length_select;
+
+  this->setVectors();
+}
+
+void
+RunLengthVector::setVectors()
+{
+  this->start_rank.set_vector(&(this->run_starts));
+  this->start_select.set_vector(&(this->run_starts));
+  this->length_select.set_vector(&(this->run_lengths));
+}
+
+//------------------------------------------------------------------------------
+
+SparseBWT::SparseBWT() :
+  fast_chars(0), char_count(0), block_count(0), data(), first_block(nullptr)
+{
+}
+
+SparseBWT::SparseBWT(const SparseBWT& source)
+{
+  this->copy(source);
+}
+
+SparseBWT::SparseBWT(SparseBWT&& source)
+{
+  *this = std::move(source);
+}
+
+SparseBWT::~SparseBWT()
+{
+}
+
+SparseBWT::SparseBWT(const std::vector<sdsl::bit_vector>& bwt, size_type fast_chars) :
+  fast_chars(fast_chars), char_count(bwt.size() - fast_chars)
+{
+  size_type n = bwt[0].size(), entry_count = 0;
+  sdsl::bit_vector buffer(n, 0);
+  for(size_type i = 0; i < n; i++)
+  {
+    for(size_type j = 0; j < this->char_count; j++)
+    {
+      if(bwt[this->charComp(j)][i]) { buffer[i] = 1; entry_count++; break; }
+    }
+  }
+
+  // There is always a block after the last entry to support rank(n, comp).
+  size_type block_words = 2 * this->char_count;
+  std::uint64_t* first = this->allocate(entry_count / BLOCK_SIZE + 1);
+  std::vector<size_type> counts(this->char_count, 0);
+  for(size_type i = 0, entry = 0; i <= n; i++)
+  {
+    if(i < n && !buffer[i]) { continue; }
+    size_type offset = entry & (BLOCK_SIZE - 1);
+    std::uint64_t* block = first + (entry / BLOCK_SIZE) * block_words;
+    if(offset == 0)
+    {
+      for(size_type j = 0; j < this->char_count; j++) { block[j] = counts[j]; }
+    }
+    if(i == n) { break; }
+    for(size_type j = 0; j < this->char_count; j++)
+    {
+      if(bwt[this->charComp(j)][i])
+      {
+        block[this->char_count + j] |= std::uint64_t(1) << offset;
+        counts[j]++;
+      }
+    }
+    entry++;
+  }
+
+  this->filter = sd_vector(buffer); sdsl::util::clear(buffer);
+  sdsl::util::init_support(this->filter_rank, &(this->filter));
+}
+
+void
+SparseBWT::swap(SparseBWT& another)
+{
+  if(this != &another)
+  {
+    std::swap(this->fast_chars, another.fast_chars);
+    std::swap(this->char_count, another.char_count);
+
+    this->filter.swap(another.filter);
+    sdsl::util::swap_support(this->filter_rank, another.filter_rank,
+      &(this->filter), &(another.filter));
+
+    std::swap(this->block_count, another.block_count);
+    this->data.swap(another.data);
+    std::swap(this->first_block, another.first_block);
+  }
+}
+
+SparseBWT&
+SparseBWT::operator=(const SparseBWT& source)
+{
+  if(this != &source) { this->copy(source); }
+  return *this;
+}
+
+SparseBWT&
+SparseBWT::operator=(SparseBWT&& source)
+{
+  if(this != &source)
+  {
+    this->fast_chars = source.fast_chars;
+    this->char_count = source.char_count;
+
+    this->filter = std::move(source.filter);
+    this->filter_rank = std::move(source.filter_rank);
+
+    this->block_count = source.block_count;
+    this->data = std::move(source.data);
+    this->first_block = source.first_block;
+    source.block_count = 0; source.first_block = nullptr;
+
+    this->setVectors();
+  }
+  return *this;
+}
+
+SparseBWT::size_type
+SparseBWT::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string name,
+                     size_type position, size_type alignment) const
+{
+  sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+  size_type written_bytes = 0;
+
+  written_bytes += sdsl::write_member(this->fast_chars, out, child, "fast_chars");
+  written_bytes += sdsl::write_member(this->char_count, out, child, "char_count");
+
+  written_bytes += this->filter.serialize(out, child, "filter");
+  written_bytes += this->filter_rank.serialize(out, child, "filter_rank");
+
+  written_bytes += sdsl::write_member(this->block_count, out, child, "block_count");
+  written_bytes += serializeWords(this->first_block, this->block_count * 2 * this->char_count, out,
+                                  position + written_bytes, child, "blocks", alignment);
+
+  sdsl::structure_tree::add_size(child, written_bytes);
+  return written_bytes;
+}
+
+void
+SparseBWT::load(std::istream& in, const MappedFile* mapping)
+{
+  sdsl::read_member(this->fast_chars, in);
+  sdsl::read_member(this->char_count, in);
+
+  this->filter.load(in);
+  this->filter_rank.load(in, &(this->filter));
+
+  size_type blocks = 0;
+  sdsl::read_member(blocks, in);
+  size_type words = loadWordCount(in);
+  if(blocks != this->entries() / BLOCK_SIZE + 1 || words != blocks * 2 * this->char_count)
+  {
+    std::cerr << "SparseBWT::load(): Invalid block count " << blocks << " for " << this->entries() << " entries" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  const std::uint64_t* mapped = (mapping != nullptr ? mapWords(in, *mapping, words) : nullptr);
+  if(mapped != nullptr)
+  {
+    this->data = WordBuffer();
+    this->block_count = blocks;
+    this->first_block = mapped;
+  }
+  else
+  {
+    loadWords(in, this->allocate(blocks), words);
+  }
+}
+
+void
+SparseBWT::copy(const SparseBWT& source)
+{
+  this->fast_chars = source.fast_chars;
+  this->char_count = source.char_count;
+
+  this->filter = source.filter;
+  this->filter_rank = source.filter_rank;
+
+  size_type words = source.block_count * 2 * source.char_count;
+  std::copy(source.first_block, source.first_block + words, this->allocate(source.block_count));
+
+  this->setVectors();
+}
+
+void
+SparseBWT::setVectors()
+{
+  this->filter_rank.set_vector(&(this->filter));
+}
+
+std::uint64_t*
+SparseBWT::allocate(size_type blocks)
+{
+  this->block_count = blocks;
+  this->data = WordBuffer(blocks * 2 * this->char_count);
+  this->first_block = this->data.data();
+  return this->data.data();
+}
+
+//------------------------------------------------------------------------------
+
+RankBitVector::RankBitVector() :
+  elements(0), block_count(0), data(), first_block(nullptr)
+{
+  this->allocate(0);
+}
+
+RankBitVector::RankBitVector(const RankBitVector& source)
+{
+  this->copy(source);
+}
+
+RankBitVector::RankBitVector(RankBitVector&& source)
+{
+  *this = std::move(source);
+}
+
+RankBitVector::~RankBitVector()
+{
+}
+
+RankBitVector::RankBitVector(const sdsl::bit_vector& source)
+{
+  std::uint64_t* block = this->allocate(source.size());
+  size_type ones = 0;
+  for(size_type i = 0; i < this->blocks(); i++, block += BLOCK_WORDS)
+  {
+    block[0] = ones;
+    for(size_type j = 0; j < DATA_WORDS; j++)
+    {
+      size_type start = i * BLOCK_BITS + j * WORD_BITS;
+      if(start >= this->size()) { break; }
+      size_type length = std::min(WORD_BITS, this->size() - start);
+      block[1 + j] = source.get_int(start, length);
+      ones += sdsl::bits::cnt(block[1 + j]);
+    }
+  }
+}
+
+void
+RankBitVector::swap(RankBitVector& another)
+{
+  if(this != &another)
+  {
+    std::swap(this->elements, another.elements);
+    std::swap(this->block_count, another.block_count);
+    this->data.swap(another.data);
+    std::swap(this->first_block, another.first_block);
+  }
+}
+
+RankBitVector&
+RankBitVector::operator=(const RankBitVector& source)
+{
+  if(this != &source) { this->copy(source); }
+  return *this;
+}
+
+RankBitVector&
+RankBitVector::operator=(RankBitVector&& source)
+{
+  if(this != &source)
+  {
+    this->elements = source.elements;
+    this->block_count = source.block_count;
+    this->data = std::move(source.data);
+    this->first_block = source.first_block;
+    source.allocate(0);
+  }
+  return *this;
+}
+
+RankBitVector::size_type
+RankBitVector::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string name,
+                         size_type position, size_type alignment) const
+{
+  sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+  size_type written_bytes = 0;
+
+  written_bytes += sdsl::write_member(this->elements, out, child, "elements");
+  written_bytes += sdsl::write_member(this->block_count, out, child, "block_count");
+  written_bytes += serializeWords(this->first_block, this->blocks() * BLOCK_WORDS, out,
+                                  position + written_bytes, child, "blocks", alignment);
+
+  sdsl::structure_tree::add_size(child, written_bytes);
+  return written_bytes;
+}
+
+void
+RankBitVector::load(std::istream& in, const MappedFile* mapping)
+{
+  size_type n = 0, blocks = 0;
+  sdsl::read_member(n, in);
+  sdsl::read_member(blocks, in);
+  size_type words = loadWordCount(in);
+  if(blocks != n / BLOCK_BITS + 1 || words != blocks * BLOCK_WORDS)
+  {
+    std::cerr << "RankBitVector::load(): Invalid block count " << blocks << " for " << n << " bits" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  const std::uint64_t* mapped = (mapping != nullptr ? mapWords(in, *mapping, words) : nullptr);
+  if(mapped != nullptr)
+  {
+    this->data = WordBuffer();
+    this->elements = n; this->block_count = blocks;
+    this->first_block = mapped;
+  }
+  else
+  {
+    loadWords(in, this->allocate(n), words);
+  }
+}
+
+void
+RankBitVector::copy(const RankBitVector& source)
+{
+  std::copy(source.first_block, source.first_block + source.blocks() * BLOCK_WORDS, this->allocate(source.size()));
+}
+
+std::uint64_t*
+RankBitVector::allocate(size_type n)
+{
+  this->elements = n;
+  this->block_count = n / BLOCK_BITS + 1;
+  this->data = WordBuffer(this->block_count * BLOCK_WORDS);
+  this->first_block = this->data.data();
+  return this->data.data();
+}
+
+//------------------------------------------------------------------------------
+
+FastBitVector::FastBitVector() :
+  rank_vector(false)
+{
+}
+
+FastBitVector::FastBitVector(const sdsl::bit_vector& source, bool rank_vector) :
+  rank_vector(rank_vector)
+{
+  if(rank_vector) { this->blocks = RankBitVector(source); }
+  else { this->plain = plain_vector(source); }
+}
+
+void
+FastBitVector::swap(FastBitVector& another)
+{
+  if(this != &another)
+  {
+    std::swap(this->rank_vector, another.rank_vector);
+    this->plain.swap(another.plain);
+    this->blocks.swap(another.blocks);
+  }
+}
+
+FastBitVector::size_type
+FastBitVector::serialize(std::ostream& out, sdsl::structure_tree_node* v, std::string name,
+                         size_type position, size_type alignment) const
+{
+  if(this->rank_vector) { return this->blocks.serialize(out, v, name, position, alignment); }
+  return this->plain.serialize(out, v, name);
+}
+
+void
+FastBitVector::load(std::istream& in, bool rank_vector, const MappedFile* mapping)
+{
+  this->rank_vector = rank_vector;
+  if(rank_vector)
+  {
+    this->plain = plain_vector();
+    this->blocks.load(in, mapping);
+  }
+  else
+  {
+    this->plain.load(in);
+    this->blocks = RankBitVector();
+  }
+}
+
+//------------------------------------------------------------------------------
+
 std::string
 Key::decode(key_type key, size_type kmer_length, const Alphabet& alpha)
 {
@@ -576,6 +1271,43 @@ Node::encode(const std::string& token)
   return encode(node, offset, reverse_complement);
 }
 
+node_type
+Node::encode(const char* token_begin, const char* token_end)
+{
+  const char* iter = token_begin;
+  size_type node = 0;
+  for(; iter != token_end && *iter >= '0' && *iter <= '9'; ++iter) { node = 10 * node + (*iter - '0'); }
+  if(iter == token_begin || iter + 1 >= token_end)
+  {
+    std::cerr << "Node::encode(): Invalid position token " << std::string(token_begin, token_end) << std::endl;
+    return 0;
+  }
+  ++iter;
+
+  bool reverse_complement = false;
+  if(*iter == '-')
+  {
+    reverse_complement = true;
+    ++iter;
+  }
+
+  const char* offset_begin = iter;
+  size_type offset = 0;
+  for(; iter != token_end && *iter >= '0' && *iter <= '9'; ++iter) { offset = 10 * offset + (*iter - '0'); }
+  if(iter == offset_begin)
+  {
+    std::cerr << "Node::encode(): Invalid position token " << std::string(token_begin, token_end) << std::endl;
+    return 0;
+  }
+  if(offset > OFFSET_MASK)
+  {
+    std::cerr << "Node::encode(): Offset " << offset << " too large" << std::endl;
+    return 0;
+  }
+
+  return encode(node, offset, reverse_complement);
+}
+
 std::string
 Node::decode(node_type node)
 {
@@ -619,6 +1351,14 @@ KMer::chars(const std::string& token, const Alphabet& alpha)
   return val;
 }
 
+byte_type
+KMer::chars(const char* token_begin, const char* token_end, const Alphabet& alpha)
+{
+  byte_type val = 0;
+  for(const char* iter = token_begin; iter < token_end; iter += 2) { val |= 1 << alpha.char2comp[*iter]; }
+  return val;
+}
+
 std::ostream&
 operator<< (std::ostream& out, const KMer& kmer)
 {
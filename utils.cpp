@@ -25,12 +25,18 @@
 
 #include <gcsa/utils.h>
 
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <set>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <gcsa/internal.h>
@@ -54,11 +60,15 @@ constexpr size_type Version::PATCH_VERSION;
 constexpr size_type Version::GCSA_VERSION;
 constexpr size_type Version::LCP_VERSION;
 
+constexpr size_type HugePages::PAGE_SIZE;
+constexpr size_type WordBuffer::ALIGNMENT;
+
 //------------------------------------------------------------------------------
 
 // Other class variables.
 
 size_type Verbosity::level = Verbosity::DEFAULT;
+HugePages::mode_type HugePages::mode = HugePages::NORMAL;
 
 //------------------------------------------------------------------------------
 
@@ -166,6 +176,7 @@ namespace TempFile
 
   const std::string DEFAULT_TEMP_DIR = ".";
   std::string temp_dir = DEFAULT_TEMP_DIR;
+  bool drop_cache = false;
 
   // By storing the filenames in a static object, we can delete the remaining
   // temporary files when std::exit() is called.
@@ -271,6 +282,380 @@ fileSize(std::ofstream& file)
 
 //------------------------------------------------------------------------------
 
+MappedFile::MappedFile() :
+  base(nullptr), bytes(0)
+{
+}
+
+MappedFile::MappedFile(const std::string& filename) :
+  base(nullptr), bytes(0)
+{
+  this->open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+  this->close();
+}
+
+bool
+MappedFile::open(const std::string& filename)
+{
+  this->close();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0)
+  {
+    std::cerr << "MappedFile::open(): Cannot open file " << filename << std::endl;
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    std::cerr << "MappedFile::open(): Cannot determine the size of " << filename << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(addr == MAP_FAILED)
+  {
+    std::cerr << "MappedFile::open(): Cannot map file " << filename << std::endl;
+    return false;
+  }
+
+  this->base = static_cast<const char*>(addr);
+  this->bytes = st.st_size;
+  return true;
+}
+
+void
+MappedFile::close()
+{
+  if(this->base != nullptr)
+  {
+    munmap(const_cast<char*>(this->base), this->bytes);
+    this->base = nullptr; this->bytes = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+MappedStreamBuffer::MappedStreamBuffer(const MappedFile& file)
+{
+  char* begin = const_cast<char*>(file.data());
+  this->setg(begin, begin, begin + file.size());
+}
+
+MappedStreamBuffer::pos_type
+MappedStreamBuffer::seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if(!(which & std::ios_base::in)) { return pos_type(off_type(-1)); }
+
+  off_type pos = offset;
+  if(dir == std::ios_base::cur) { pos += this->gptr() - this->eback(); }
+  else if(dir == std::ios_base::end) { pos += this->egptr() - this->eback(); }
+  if(pos < 0 || pos > this->egptr() - this->eback()) { return pos_type(off_type(-1)); }
+
+  this->setg(this->eback(), this->eback() + pos, this->egptr());
+  return pos_type(pos);
+}
+
+MappedStreamBuffer::pos_type
+MappedStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+  return this->seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+//------------------------------------------------------------------------------
+
+size_type
+serializeWords(const std::uint64_t* data, size_type words, std::ostream& out, size_type position,
+               sdsl::structure_tree_node* v, std::string name, size_type alignment)
+{
+  sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(v, name, "aligned_words");
+  size_type written_bytes = 0;
+
+  std::streamoff offset = out.tellp();
+  if(offset >= 0) { position = offset; }
+  position += 2 * sizeof(size_type);
+  size_type padding = (alignment - position % alignment) % alignment;
+  written_bytes += sdsl::write_member(words, out, child, "words");
+  written_bytes += sdsl::write_member(padding, out, child, "padding");
+  std::vector<char> zeros(padding, 0);
+  out.write(zeros.data(), padding);
+  out.write(reinterpret_cast<const char*>(data), words * sizeof(std::uint64_t));
+  written_bytes += padding + words * sizeof(std::uint64_t);
+
+  sdsl::structure_tree::add_size(child, written_bytes);
+  return written_bytes;
+}
+
+size_type
+loadWordCount(std::istream& in)
+{
+  size_type words = 0, padding = 0;
+  sdsl::read_member(words, in);
+  sdsl::read_member(padding, in);
+  in.ignore(padding);
+  return words;
+}
+
+void
+loadWords(std::istream& in, std::uint64_t* buffer, size_type words)
+{
+  in.read(reinterpret_cast<char*>(buffer), words * sizeof(std::uint64_t));
+}
+
+const std::uint64_t*
+mapWords(std::istream& in, const MappedFile& mapping, size_type words)
+{
+  std::streamoff pos = in.tellg();
+  if(pos >= 0 && pos % sizeof(std::uint64_t) != 0) { return nullptr; }
+  if(pos < 0 || pos + words * sizeof(std::uint64_t) > mapping.size())
+  {
+    std::cerr << "mapWords(): Invalid array at offset " << pos << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  in.seekg(words * sizeof(std::uint64_t), std::ios_base::cur);
+  return reinterpret_cast<const std::uint64_t*>(mapping.data() + pos);
+}
+
+//------------------------------------------------------------------------------
+
+void
+HugePages::set(mode_type new_mode)
+{
+  mode = new_mode;
+}
+
+std::string
+HugePages::modeName()
+{
+  switch(mode)
+  {
+    case NORMAL:
+      return "normal"; break;
+    case TRANSPARENT:
+      return "transparent"; break;
+    case EXPLICIT:
+      return "explicit"; break;
+  }
+  return "unknown";
+}
+
+void
+HugePages::advise(const void* data, size_type bytes)
+{
+#ifdef MADV_HUGEPAGE
+  if(mode == NORMAL || data == nullptr || bytes < PAGE_SIZE) { return; }
+
+  // madvise() requires the start to be aligned at a system page boundary.
+  size_type page = sysconf(_SC_PAGESIZE);
+  std::uintptr_t start = reinterpret_cast<std::uintptr_t>(data);
+  std::uintptr_t aligned = ((start + page - 1) / page) * page;
+  if(aligned - start >= bytes) { return; }
+  madvise(reinterpret_cast<void*>(aligned), bytes - (aligned - start), MADV_HUGEPAGE);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+WordBuffer::WordBuffer() :
+  buffer(nullptr), words(0), mapped_bytes(0)
+{
+}
+
+WordBuffer::WordBuffer(size_type n) :
+  buffer(nullptr), words(n), mapped_bytes(0)
+{
+  if(n == 0) { return; }
+  size_type bytes = n * sizeof(std::uint64_t);
+
+#ifdef MADV_HUGEPAGE
+  if(HugePages::mode != HugePages::NORMAL && bytes >= HugePages::PAGE_SIZE)
+  {
+    size_type rounded = ((bytes + HugePages::PAGE_SIZE - 1) / HugePages::PAGE_SIZE) * HugePages::PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    if(HugePages::mode == HugePages::EXPLICIT)
+    {
+      void* addr = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if(addr != MAP_FAILED)
+      {
+        this->buffer = static_cast<std::uint64_t*>(addr); this->mapped_bytes = rounded;
+        return;
+      }
+    }
+#endif
+    // Transparent huge pages are only used for 2 MB aligned regions, so we map an
+    // extra page and unmap the unaligned head and the tail.
+    void* addr = mmap(nullptr, rounded + HugePages::PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(addr != MAP_FAILED)
+    {
+      std::uintptr_t start = reinterpret_cast<std::uintptr_t>(addr);
+      std::uintptr_t aligned = ((start + HugePages::PAGE_SIZE - 1) / HugePages::PAGE_SIZE) * HugePages::PAGE_SIZE;
+      if(aligned > start) { munmap(addr, aligned - start); }
+      size_type tail = HugePages::PAGE_SIZE - (aligned - start);
+      if(tail > 0) { munmap(reinterpret_cast<void*>(aligned + rounded), tail); }
+      madvise(reinterpret_cast<void*>(aligned), rounded, MADV_HUGEPAGE);
+      this->buffer = reinterpret_cast<std::uint64_t*>(aligned); this->mapped_bytes = rounded;
+      return;
+    }
+  }
+#endif
+
+  void* addr = nullptr;
+  if(posix_memalign(&addr, ALIGNMENT, bytes) != 0)
+  {
+    std::cerr << "WordBuffer::WordBuffer(): Cannot allocate " << bytes << " bytes" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::memset(addr, 0, bytes);
+  this->buffer = static_cast<std::uint64_t*>(addr);
+}
+
+WordBuffer::WordBuffer(WordBuffer&& source) :
+  buffer(nullptr), words(0), mapped_bytes(0)
+{
+  this->swap(source);
+}
+
+WordBuffer::~WordBuffer()
+{
+  this->release();
+}
+
+void
+WordBuffer::swap(WordBuffer& another)
+{
+  if(this != &another)
+  {
+    std::swap(this->buffer, another.buffer);
+    std::swap(this->words, another.words);
+    std::swap(this->mapped_bytes, another.mapped_bytes);
+  }
+}
+
+WordBuffer&
+WordBuffer::operator=(WordBuffer&& source)
+{
+  if(this != &source)
+  {
+    this->release();
+    this->swap(source);
+  }
+  return *this;
+}
+
+void
+WordBuffer::release()
+{
+  if(this->mapped()) { munmap(this->buffer, this->mapped_bytes); }
+  else { std::free(this->buffer); }
+  this->buffer = nullptr; this->words = 0; this->mapped_bytes = 0;
+}
+
+//------------------------------------------------------------------------------
+
+namespace NUMA
+{
+  // Dense node numbers for the nodes with CPUs.
+  struct Topology
+  {
+    std::vector<std::vector<size_type>> node_cpus;
+    std::vector<size_type>              cpu_to_node;
+
+    Topology()
+    {
+#ifdef __linux__
+      std::vector<size_type> ids = parseList(readLine("/sys/devices/system/node/online"));
+      for(size_type id : ids)
+      {
+        std::vector<size_type> cpus = parseList(readLine("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+        if(cpus.empty()) { continue; }
+        for(size_type cpu : cpus)
+        {
+          if(cpu >= this->cpu_to_node.size()) { this->cpu_to_node.resize(cpu + 1, 0); }
+          this->cpu_to_node[cpu] = this->node_cpus.size();
+        }
+        this->node_cpus.push_back(cpus);
+      }
+#endif
+      if(this->node_cpus.empty()) { this->node_cpus.push_back(std::vector<size_type>()); }
+    }
+
+    static std::string readLine(const std::string& filename)
+    {
+      std::ifstream in(filename.c_str());
+      std::string line;
+      if(in) { std::getline(in, line); }
+      return line;
+    }
+
+    // Parses lists such as "0-3,8-11".
+    static std::vector<size_type> parseList(const std::string& list)
+    {
+      std::vector<size_type> result;
+      std::istringstream in(list);
+      std::string item;
+      while(std::getline(in, item, ','))
+      {
+        if(item.empty() || !std::isdigit(static_cast<unsigned char>(item[0]))) { continue; }
+        size_type separator = item.find('-');
+        size_type first = std::stoul(item.substr(0, separator)), last = first;
+        if(separator != std::string::npos) { last = std::stoul(item.substr(separator + 1)); }
+        for(size_type i = first; i <= last; i++) { result.push_back(i); }
+      }
+      return result;
+    }
+  };
+
+  const Topology&
+  topology()
+  {
+    static Topology result;
+    return result;
+  }
+
+  size_type
+  nodes()
+  {
+    return topology().node_cpus.size();
+  }
+
+  size_type
+  currentNode()
+  {
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    const Topology& topo = topology();
+    if(cpu >= 0 && static_cast<size_type>(cpu) < topo.cpu_to_node.size()) { return topo.cpu_to_node[cpu]; }
+#endif
+    return 0;
+  }
+
+  bool
+  bindThread(size_type node)
+  {
+#ifdef __linux__
+    const Topology& topo = topology();
+    if(node >= topo.node_cpus.size() || topo.node_cpus[node].empty()) { return false; }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for(size_type cpu : topo.node_cpus[node])
+    {
+      if(cpu < CPU_SETSIZE) { CPU_SET(cpu, &cpus); }
+    }
+    return (sched_setaffinity(0, sizeof(cpus), &cpus) == 0);
+#else
+    return false;
+#endif
+  }
+} // namespace NUMA
+
+//------------------------------------------------------------------------------
+
 size_type
 getChunkSize(size_type n, size_type min_size)
 {